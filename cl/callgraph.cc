@@ -25,6 +25,13 @@
 #include <cl/storage.hh>
 
 #include "stopwatch.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <stack>
+#include <vector>
 
 #include <boost/foreach.hpp>
 
@@ -114,6 +121,108 @@ void handleFnc(Fnc *const fnc) {
     }
 }
 
+struct SccItem {
+    Node                           *node;
+    TInsnListByFnc::const_iterator  next;
+
+    SccItem(Node *node_):
+        node(node_),
+        next(node_->calls.begin())
+    {
+    }
+};
+
+struct SccFinder {
+    Graph                          &cg;
+    std::map<const Node *, int>     idxByNode;
+    std::map<const Node *, int>     lowByNode;
+    std::vector<Node *>             sccStack;
+    std::set<const Node *>          onStack;
+    std::stack<SccItem>             dfsStack;
+
+    SccFinder(Graph &cg_):
+        cg(cg_)
+    {
+    }
+
+    void enter(Node *node);
+    void leave(Node *node);
+    void run(Node *node);
+};
+
+void SccFinder::enter(Node *node) {
+    const int idx = idxByNode.size();
+    idxByNode[node] = idx;
+    lowByNode[node] = idx;
+    sccStack.push_back(node);
+    onStack.insert(node);
+    dfsStack.push(SccItem(node));
+}
+
+void SccFinder::leave(Node *node) {
+    if (lowByNode[node] != idxByNode[node])
+        // not the root of its SCC
+        return;
+
+    const int scc = cg.sccs.size();
+    cg.sccs.push_back(TSccNodes());
+    TSccNodes &nodes = cg.sccs.back();
+
+    Node *top;
+    do {
+        top = sccStack.back();
+        sccStack.pop_back();
+        onStack.erase(top);
+
+        top->scc = scc;
+        nodes.push_back(top);
+    }
+    while (top != node);
+
+    if (1 < nodes.size()) {
+        BOOST_FOREACH(Node *member, nodes)
+            member->isRecursive = true;
+    }
+}
+
+// Tarjan's algorithm, SCCs are completed in the reverse topological order
+void SccFinder::run(Node *root) {
+    this->enter(root);
+    while (!dfsStack.empty()) {
+        SccItem &top = dfsStack.top();
+        Node *const node = top.node;
+        if (node->calls.end() == top.next) {
+            dfsStack.pop();
+            this->leave(node);
+            if (!dfsStack.empty()) {
+                int &low = lowByNode[dfsStack.top().node];
+                low = std::min(low, lowByNode[node]);
+            }
+
+            continue;
+        }
+
+        Fnc *const callee = (top.next++)->first;
+        if (!callee)
+            // indirect call
+            continue;
+
+        Node *const calleeNode = callee->cgNode;
+        if (calleeNode == node)
+            node->isRecursive = true;
+
+        if (!hasKey(idxByNode, calleeNode)) {
+            this->enter(calleeNode);
+            continue;
+        }
+
+        if (hasKey(onStack, calleeNode)) {
+            int &low = lowByNode[node];
+            low = std::min(low, idxByNode[calleeNode]);
+        }
+    }
+}
+
 void buildCallGraph(const Storage &stor) {
     StopWatch watch;
 
@@ -127,6 +236,14 @@ void buildCallGraph(const Storage &stor) {
             BOOST_FOREACH(const TOp op, insn->operands)
                 handleCallback(cg, /* node */ 0, insn, op);
 
+    // find strongly connected components, callees first
+    SccFinder finder(cg);
+    BOOST_FOREACH(Fnc *fnc, stor.fncs) {
+        Node *const node = fnc->cgNode;
+        if (!hasKey(finder.idxByNode, node))
+            finder.run(node);
+    }
+
     CL_DEBUG("buildCallGraph() took " << watch);
 }
 
@@ -22,7 +22,7 @@
 
 /**
  * @file callgraph.hh
- * @todo some dox
+ * buildCallGraph - call graph of the whole program, see CallGraph::Graph
  */
 
 namespace CodeStorage {
@@ -31,6 +31,10 @@ struct Storage;
 
 namespace CallGraph {
 
+/**
+ * build the call graph, including its strongly connected components ordered
+ * bottom-up, i.e. leaves first (see CallGraph::Graph::sccs)
+ */
 void buildCallGraph(const Storage &);
 
 } // namespace CallGraph
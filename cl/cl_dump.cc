@@ -0,0 +1,1441 @@
+/*
+ * Copyright (C) 2012 Kamil Dudka <kdudka@redhat.com>
+ *
+ * This file is part of predator.
+ *
+ * predator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * predator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with predator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config_cl.h"
+#include "cl_dump.hh"
+
+#include <cl/cl_msg.hh>
+
+#include "cl.hh"
+#include "cl_private.hh"
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/foreach.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// /////////////////////////////////////////////////////////////////////////////
+// file format shared by the writer and the loader
+//
+// The file starts with dumpMagic and is followed by a stream of records.  Each
+// record starts with a tag (single byte).  Integers are written as variable
+// length quantities (7 bits per byte, signed integers zig-zag encoded).  Types,
+// variables and strings are written as separate definition records, each of
+// them before the first record that refers to them (types and variables may
+// still refer to each other in a cycle).  Strings are referred to by their
+// index (zero stands for NULL) and terminated by zero, so that the loader can
+// use them directly from the mapped memory.  Floating-point numbers are stored
+// in the native representation, the format is not portable across platforms.
+namespace {
+    const char dumpMagic[] = "CLDUMP\001";
+
+    enum EDumpTag {
+        DT_STRING = 1,
+        DT_TYPE,
+        DT_VAR,
+        DT_FILE_OPEN,
+        DT_FILE_CLOSE,
+        DT_FNC_OPEN,
+        DT_FNC_ARG_DECL,
+        DT_FNC_CLOSE,
+        DT_BB_OPEN,
+        DT_INSN,
+        DT_INSN_CALL_OPEN,
+        DT_INSN_CALL_ARG,
+        DT_INSN_CALL_CLOSE,
+        DT_INSN_SWITCH_OPEN,
+        DT_INSN_SWITCH_CASE,
+        DT_INSN_SWITCH_CLOSE,
+        DT_ACKNOWLEDGE
+    };
+}
+
+// /////////////////////////////////////////////////////////////////////////////
+// ClDump implementation
+class ClDump: public ICodeListener {
+    public:
+        ClDump(const char *fileName);
+        virtual ~ClDump();
+
+        bool isOk() const { return out_; }
+
+        virtual void file_open(
+            const char              *file_name);
+
+        virtual void file_close();
+
+        virtual void fnc_open(
+            const struct cl_operand *fnc);
+
+        virtual void fnc_arg_decl(
+            int                     arg_id,
+            const struct cl_operand *arg_src);
+
+        virtual void fnc_close();
+
+        virtual void bb_open(
+            const char              *bb_name);
+
+        virtual void insn(
+            const struct cl_insn    *cli);
+
+        virtual void insn_call_open(
+            const struct cl_loc     *loc,
+            const struct cl_operand *dst,
+            const struct cl_operand *fnc);
+
+        virtual void insn_call_arg(
+            int                     arg_id,
+            const struct cl_operand *arg_src);
+
+        virtual void insn_call_close();
+
+        virtual void insn_switch_open(
+            const struct cl_loc     *loc,
+            const struct cl_operand *src);
+
+        virtual void insn_switch_case(
+            const struct cl_loc     *loc,
+            const struct cl_operand *val_lo,
+            const struct cl_operand *val_hi,
+            const char              *label);
+
+        virtual void insn_switch_close();
+
+        virtual void acknowledge();
+
+    private:
+        typedef std::map<std::string, unsigned>     TStrMap;
+        typedef std::set<int>                       TUidSet;
+
+        std::string                 fname_;
+        FILE                        *out_;
+        TStrMap                     strMap_;
+        TUidSet                     typesDone_;
+        TUidSet                     varsDone_;
+
+        // definitions (written before the records that refer to them)
+        void defStr(const char *);
+        void defLoc(const struct cl_loc *);
+        void defType(const struct cl_type *);
+        void defVar(const struct cl_var *);
+        void defOperand(const struct cl_operand *);
+        void defInsn(const struct cl_insn *);
+
+        // primitive writers
+        void writeTag(EDumpTag);
+        void writeBool(bool);
+        void writeUnsigned(unsigned long);
+        void writeInt(long);
+        void writeReal(double);
+        void writeStr(const char *);
+        void writeLoc(const struct cl_loc *);
+        void writeType(const struct cl_type *);
+        void writeOperand(const struct cl_operand *);
+        void writeInsn(const struct cl_insn *);
+};
+
+ClDump::ClDump(const char *fileName):
+    fname_(fileName),
+    out_(fopen(fileName, "w"))
+{
+    if (!out_) {
+        CL_ERROR("unable to create file '" << fileName << "'");
+        return;
+    }
+
+    fwrite(dumpMagic, sizeof dumpMagic, 1, out_);
+}
+
+ClDump::~ClDump() {
+    if (!out_)
+        return;
+
+    // the stream has to be closed even if a write error has been seen
+    const bool failed = ferror(out_);
+    if (fclose(out_) || failed)
+        CL_ERROR("error while writing to '" << fname_ << "'");
+}
+
+void ClDump::writeTag(EDumpTag tag) {
+    putc(tag, out_);
+}
+
+void ClDump::writeBool(bool val) {
+    putc(val, out_);
+}
+
+void ClDump::writeUnsigned(unsigned long val) {
+    for (; 0x7F < val; val >>= 7)
+        putc(0x80 | (val & 0x7F), out_);
+
+    putc(val, out_);
+}
+
+void ClDump::writeInt(long val) {
+    // zig-zag encoding keeps small negative numbers small
+    const unsigned long uval = static_cast<unsigned long>(val);
+    this->writeUnsigned((val < 0)
+            ? ((~uval) << 1) | 1UL
+            : uval << 1);
+}
+
+void ClDump::writeReal(double val) {
+    fwrite(&val, sizeof val, 1, out_);
+}
+
+void ClDump::defStr(const char *str) {
+    if (!str)
+        return;
+
+    const unsigned idx = strMap_.size() + /* NULL */ 1;
+    std::pair<TStrMap::iterator, bool> ret =
+        strMap_.insert(std::make_pair(std::string(str), idx));
+    if (!ret.second)
+        // already defined
+        return;
+
+    const size_t len = strlen(str);
+    this->writeTag(DT_STRING);
+    this->writeUnsigned(len);
+    fwrite(str, len + /* trailing zero */ 1, 1, out_);
+}
+
+void ClDump::writeStr(const char *str) {
+    if (!str) {
+        this->writeUnsigned(0);
+        return;
+    }
+
+    TStrMap::const_iterator it = strMap_.find(str);
+    CL_BREAK_IF(strMap_.end() == it);
+    this->writeUnsigned(it->second);
+}
+
+void ClDump::defLoc(const struct cl_loc *loc) {
+    if (loc)
+        this->defStr(loc->file);
+}
+
+void ClDump::writeLoc(const struct cl_loc *loc) {
+    if (!loc)
+        loc = &cl_loc_unknown;
+
+    this->writeStr(loc->file);
+    this->writeInt(loc->line);
+    this->writeInt(loc->column);
+    this->writeBool(loc->sysp);
+}
+
+void ClDump::defType(const struct cl_type *clt) {
+    if (!clt || !typesDone_.insert(clt->uid).second)
+        // NULL or already defined (or being defined in case of a cycle)
+        return;
+
+    this->defLoc(&clt->loc);
+    this->defStr(clt->name);
+    for (int i = 0; i < clt->item_cnt; ++i) {
+        const struct cl_type_item *item = clt->items + i;
+        this->defType(item->type);
+        this->defStr(item->name);
+    }
+
+    this->writeTag(DT_TYPE);
+    this->writeInt(clt->uid);
+    this->writeUnsigned(clt->code);
+    this->writeLoc(&clt->loc);
+    this->writeUnsigned(clt->scope);
+    this->writeStr(clt->name);
+    this->writeInt(clt->size);
+    this->writeUnsigned(clt->item_cnt);
+    for (int i = 0; i < clt->item_cnt; ++i) {
+        const struct cl_type_item *item = clt->items + i;
+        this->writeType(item->type);
+        this->writeStr(item->name);
+        this->writeInt(item->offset);
+    }
+    this->writeInt(clt->array_size);
+    this->writeBool(clt->is_unsigned);
+}
+
+void ClDump::writeType(const struct cl_type *clt) {
+    this->writeBool(clt);
+    if (clt)
+        this->writeInt(clt->uid);
+}
+
+void ClDump::defVar(const struct cl_var *var) {
+    if (!varsDone_.insert(var->uid).second)
+        // already defined (or being defined in case of a cycle)
+        return;
+
+    this->defStr(var->name);
+    this->defLoc(&var->loc);
+
+    unsigned cntInit = 0;
+    for (const struct cl_initializer *in = var->initial; in; in = in->next) {
+        this->defInsn(&in->insn);
+        ++cntInit;
+    }
+
+    this->writeTag(DT_VAR);
+    this->writeInt(var->uid);
+    this->writeStr(var->name);
+    this->writeBool(var->artificial);
+    this->writeLoc(&var->loc);
+    this->writeBool(var->initialized);
+    this->writeBool(var->is_extern);
+    this->writeUnsigned(cntInit);
+    for (const struct cl_initializer *in = var->initial; in; in = in->next)
+        this->writeInsn(&in->insn);
+}
+
+void ClDump::defOperand(const struct cl_operand *op) {
+    if (!op)
+        return;
+
+    this->defType(op->type);
+    for (const struct cl_accessor *ac = op->accessor; ac; ac = ac->next) {
+        this->defType(ac->type);
+        if (CL_ACCESSOR_DEREF_ARRAY == ac->code)
+            this->defOperand(ac->data.array.index);
+    }
+
+    switch (op->code) {
+        case CL_OPERAND_VOID:
+            break;
+
+        case CL_OPERAND_VAR:
+            this->defVar(op->data.var);
+            break;
+
+        case CL_OPERAND_CST: {
+            const struct cl_cst &cst = op->data.cst;
+            if (CL_TYPE_FNC == cst.code) {
+                this->defStr(cst.data.cst_fnc.name);
+                this->defLoc(&cst.data.cst_fnc.loc);
+            }
+            else if (CL_TYPE_STRING == cst.code)
+                this->defStr(cst.data.cst_string.value);
+            break;
+        }
+    }
+}
+
+void ClDump::writeOperand(const struct cl_operand *op) {
+    // zero stands for NULL, any valid operand code is shifted by one
+    if (!op) {
+        this->writeUnsigned(0);
+        return;
+    }
+
+    this->writeUnsigned(op->code + 1);
+    this->writeUnsigned(op->scope);
+    this->writeType(op->type);
+
+    unsigned cntAc = 0;
+    for (const struct cl_accessor *ac = op->accessor; ac; ac = ac->next)
+        ++cntAc;
+
+    this->writeUnsigned(cntAc);
+    for (const struct cl_accessor *ac = op->accessor; ac; ac = ac->next) {
+        this->writeUnsigned(ac->code);
+        this->writeType(ac->type);
+        switch (ac->code) {
+            case CL_ACCESSOR_DEREF_ARRAY:
+                this->writeOperand(ac->data.array.index);
+                break;
+
+            case CL_ACCESSOR_ITEM:
+                this->writeInt(ac->data.item.id);
+                break;
+
+            case CL_ACCESSOR_OFFSET:
+                this->writeInt(ac->data.offset.off);
+                break;
+
+            case CL_ACCESSOR_REF:
+            case CL_ACCESSOR_DEREF:
+                break;
+        }
+    }
+
+    switch (op->code) {
+        case CL_OPERAND_VOID:
+            break;
+
+        case CL_OPERAND_VAR:
+            this->writeInt(op->data.var->uid);
+            break;
+
+        case CL_OPERAND_CST: {
+            const struct cl_cst &cst = op->data.cst;
+            this->writeUnsigned(cst.code);
+            switch (cst.code) {
+                case CL_TYPE_FNC:
+                    this->writeInt(cst.data.cst_fnc.uid);
+                    this->writeStr(cst.data.cst_fnc.name);
+                    this->writeBool(cst.data.cst_fnc.is_extern);
+                    this->writeLoc(&cst.data.cst_fnc.loc);
+                    break;
+
+                case CL_TYPE_STRING:
+                    this->writeStr(cst.data.cst_string.value);
+                    break;
+
+                case CL_TYPE_REAL:
+                    this->writeReal(cst.data.cst_real.value);
+                    break;
+
+                default:
+                    // CL_TYPE_INT, CL_TYPE_PTR, CL_TYPE_BOOL, CL_TYPE_ENUM, ...
+                    this->writeInt(cst.data.cst_int.value);
+                    break;
+            }
+            break;
+        }
+    }
+}
+
+void ClDump::defInsn(const struct cl_insn *cli) {
+    this->defLoc(&cli->loc);
+    switch (cli->code) {
+        case CL_INSN_JMP:
+            this->defStr(cli->data.insn_jmp.label);
+            break;
+
+        case CL_INSN_COND:
+            this->defOperand(cli->data.insn_cond.src);
+            this->defStr(cli->data.insn_cond.then_label);
+            this->defStr(cli->data.insn_cond.else_label);
+            break;
+
+        case CL_INSN_RET:
+            this->defOperand(cli->data.insn_ret.src);
+            break;
+
+        case CL_INSN_UNOP:
+            this->defOperand(cli->data.insn_unop.dst);
+            this->defOperand(cli->data.insn_unop.src);
+            break;
+
+        case CL_INSN_BINOP:
+            this->defOperand(cli->data.insn_binop.dst);
+            this->defOperand(cli->data.insn_binop.src1);
+            this->defOperand(cli->data.insn_binop.src2);
+            break;
+
+        case CL_INSN_LABEL:
+            this->defStr(cli->data.insn_label.name);
+            break;
+
+        default:
+            break;
+    }
+}
+
+void ClDump::writeInsn(const struct cl_insn *cli) {
+    this->writeUnsigned(cli->code);
+    this->writeLoc(&cli->loc);
+    switch (cli->code) {
+        case CL_INSN_JMP:
+            this->writeStr(cli->data.insn_jmp.label);
+            break;
+
+        case CL_INSN_COND:
+            this->writeOperand(cli->data.insn_cond.src);
+            this->writeStr(cli->data.insn_cond.then_label);
+            this->writeStr(cli->data.insn_cond.else_label);
+            break;
+
+        case CL_INSN_RET:
+            this->writeOperand(cli->data.insn_ret.src);
+            break;
+
+        case CL_INSN_UNOP:
+            this->writeUnsigned(cli->data.insn_unop.code);
+            this->writeOperand(cli->data.insn_unop.dst);
+            this->writeOperand(cli->data.insn_unop.src);
+            break;
+
+        case CL_INSN_BINOP:
+            this->writeUnsigned(cli->data.insn_binop.code);
+            this->writeOperand(cli->data.insn_binop.dst);
+            this->writeOperand(cli->data.insn_binop.src1);
+            this->writeOperand(cli->data.insn_binop.src2);
+            break;
+
+        case CL_INSN_LABEL:
+            this->writeStr(cli->data.insn_label.name);
+            break;
+
+        default:
+            break;
+    }
+}
+
+void ClDump::file_open(const char *file_name) {
+    this->defStr(file_name);
+    this->writeTag(DT_FILE_OPEN);
+    this->writeStr(file_name);
+}
+
+void ClDump::file_close() {
+    this->writeTag(DT_FILE_CLOSE);
+}
+
+void ClDump::fnc_open(const struct cl_operand *fnc) {
+    this->defOperand(fnc);
+    this->writeTag(DT_FNC_OPEN);
+    this->writeOperand(fnc);
+}
+
+void ClDump::fnc_arg_decl(int arg_id, const struct cl_operand *arg_src) {
+    this->defOperand(arg_src);
+    this->writeTag(DT_FNC_ARG_DECL);
+    this->writeInt(arg_id);
+    this->writeOperand(arg_src);
+}
+
+void ClDump::fnc_close() {
+    this->writeTag(DT_FNC_CLOSE);
+}
+
+void ClDump::bb_open(const char *bb_name) {
+    this->defStr(bb_name);
+    this->writeTag(DT_BB_OPEN);
+    this->writeStr(bb_name);
+}
+
+void ClDump::insn(const struct cl_insn *cli) {
+    this->defInsn(cli);
+    this->writeTag(DT_INSN);
+    this->writeInsn(cli);
+}
+
+void ClDump::insn_call_open(
+        const struct cl_loc         *loc,
+        const struct cl_operand     *dst,
+        const struct cl_operand     *fnc)
+{
+    this->defLoc(loc);
+    this->defOperand(dst);
+    this->defOperand(fnc);
+    this->writeTag(DT_INSN_CALL_OPEN);
+    this->writeLoc(loc);
+    this->writeOperand(dst);
+    this->writeOperand(fnc);
+}
+
+void ClDump::insn_call_arg(int arg_id, const struct cl_operand *arg_src) {
+    this->defOperand(arg_src);
+    this->writeTag(DT_INSN_CALL_ARG);
+    this->writeInt(arg_id);
+    this->writeOperand(arg_src);
+}
+
+void ClDump::insn_call_close() {
+    this->writeTag(DT_INSN_CALL_CLOSE);
+}
+
+void ClDump::insn_switch_open(
+        const struct cl_loc         *loc,
+        const struct cl_operand     *src)
+{
+    this->defLoc(loc);
+    this->defOperand(src);
+    this->writeTag(DT_INSN_SWITCH_OPEN);
+    this->writeLoc(loc);
+    this->writeOperand(src);
+}
+
+void ClDump::insn_switch_case(
+        const struct cl_loc         *loc,
+        const struct cl_operand     *val_lo,
+        const struct cl_operand     *val_hi,
+        const char                  *label)
+{
+    this->defLoc(loc);
+    this->defOperand(val_lo);
+    this->defOperand(val_hi);
+    this->defStr(label);
+    this->writeTag(DT_INSN_SWITCH_CASE);
+    this->writeLoc(loc);
+    this->writeOperand(val_lo);
+    this->writeOperand(val_hi);
+    this->writeStr(label);
+}
+
+void ClDump::insn_switch_close() {
+    this->writeTag(DT_INSN_SWITCH_CLOSE);
+}
+
+void ClDump::acknowledge() {
+    this->writeTag(DT_ACKNOWLEDGE);
+    fflush(out_);
+}
+
+// /////////////////////////////////////////////////////////////////////////////
+// code model loader
+struct cl_code_model {
+    typedef std::map<int, struct cl_type *>             TTypeMap;
+    typedef std::map<int, struct cl_var *>              TVarMap;
+    typedef std::map<int, enum cl_scope_e>              TScopeMap;
+    typedef std::map<int, const char *>                 TNameMap;
+    typedef std::map<int, int>                          TUidMap;
+
+    std::string                             fileName;
+    const unsigned char                     *base;
+    size_t                                  size;
+
+    // data created by cl_code_model_replay(), freed by cl_code_model_free()
+    TTypeMap                                typeMap;
+    TVarMap                                 varMap;
+    std::vector<struct cl_operand *>        opList;
+    std::vector<struct cl_accessor *>       acList;
+    std::vector<struct cl_initializer *>    initList;
+
+    // declarations seen by the scan of cl_code_model_link()
+    TScopeMap                               varScopes;
+    TScopeMap                               fncScopes;
+    TNameMap                                fncNames;
+
+    // uids of the model resolved by cl_code_model_link()
+    bool                                    linked;
+    TVarMap                                 varLinks;
+    TUidMap                                 fncUids;
+
+    cl_code_model():
+        base(0),
+        size(0),
+        linked(false)
+    {
+    }
+};
+
+class ModelReader {
+    public:
+        /// if scan is true, declarations are recorded for cl_code_model_link()
+        ModelReader(cl_code_model &model, bool scan = false):
+            model_(model),
+            beg_(model.base),
+            cur_(model.base + sizeof dumpMagic),
+            end_(model.base + model.size),
+            err_(false),
+            scan_(scan)
+        {
+            // index zero stands for NULL
+            strTab_.push_back(0);
+        }
+
+        bool replay(struct cl_code_listener *);
+
+    private:
+        typedef std::vector<const char *>           TStrTab;
+
+        cl_code_model               &model_;
+        const unsigned char         *beg_;
+        const unsigned char         *cur_;
+        const unsigned char         *end_;
+        bool                        err_;
+        const bool                  scan_;
+        TStrTab                     strTab_;
+
+        unsigned char readByte();
+        bool readBool() { return this->readByte(); }
+        unsigned long readUnsigned();
+        long readInt();
+        double readReal();
+        const char* readStr();
+        void readLoc(struct cl_loc *);
+        struct cl_type* typeByUid(int uid);
+        struct cl_var* varByUid(int uid);
+        struct cl_var* resolveVar(int uid, enum cl_scope_e scope);
+        int resolveFnc(int uid, enum cl_scope_e scope, const char *name);
+        struct cl_type* readType();
+        struct cl_operand* readOperand();
+        void readInsn(struct cl_insn *);
+
+        void readStrDef();
+        void readTypeDef();
+        void readVarDef();
+};
+
+unsigned char ModelReader::readByte() {
+    if (end_ <= cur_) {
+        err_ = true;
+        return 0;
+    }
+
+    return *cur_++;
+}
+
+unsigned long ModelReader::readUnsigned() {
+    unsigned long val = 0UL;
+    for (unsigned shift = 0U; !err_; shift += 7U) {
+        if (8U * sizeof val <= shift) {
+            // too long sequence
+            err_ = true;
+            break;
+        }
+
+        const unsigned char byte = this->readByte();
+        val |= static_cast<unsigned long>(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            break;
+    }
+
+    return val;
+}
+
+long ModelReader::readInt() {
+    const unsigned long uval = this->readUnsigned();
+    return (uval & 1UL)
+        ? static_cast<long>(~(uval >> 1))
+        : static_cast<long>(uval >> 1);
+}
+
+double ModelReader::readReal() {
+    double val = 0.0;
+    if (end_ - cur_ < static_cast<long>(sizeof val)) {
+        err_ = true;
+        return val;
+    }
+
+    memcpy(&val, cur_, sizeof val);
+    cur_ += sizeof val;
+    return val;
+}
+
+const char* ModelReader::readStr() {
+    const unsigned long idx = this->readUnsigned();
+    if (strTab_.size() <= idx) {
+        err_ = true;
+        return 0;
+    }
+
+    return strTab_[idx];
+}
+
+void ModelReader::readLoc(struct cl_loc *loc) {
+    loc->file   = this->readStr();
+    loc->line   = this->readInt();
+    loc->column = this->readInt();
+    loc->sysp   = this->readBool();
+}
+
+struct cl_type* ModelReader::typeByUid(int uid) {
+    // create a placeholder if the type is not defined yet
+    struct cl_type *&ref = model_.typeMap[uid];
+    if (!ref) {
+        ref = new struct cl_type();
+        ref->uid = uid;
+    }
+
+    return ref;
+}
+
+struct cl_var* ModelReader::varByUid(int uid) {
+    // create a placeholder if the var is not defined yet
+    struct cl_var *&ref = model_.varMap[uid];
+    if (!ref) {
+        ref = new struct cl_var();
+        ref->uid = uid;
+    }
+
+    return ref;
+}
+
+struct cl_var* ModelReader::resolveVar(int uid, enum cl_scope_e scope) {
+    if (scan_)
+        model_.varScopes[uid] = scope;
+
+    if (!model_.linked)
+        return this->varByUid(uid);
+
+    const cl_code_model::TVarMap::const_iterator it = model_.varLinks.find(uid);
+    if (model_.varLinks.end() == it) {
+        // not seen by the scan of cl_code_model_link()
+        err_ = true;
+        return 0;
+    }
+
+    return it->second;
+}
+
+int ModelReader::resolveFnc(int uid, enum cl_scope_e scope, const char *name) {
+    if (scan_) {
+        model_.fncScopes[uid] = scope;
+        model_.fncNames[uid] = name;
+    }
+
+    if (!model_.linked)
+        return uid;
+
+    const cl_code_model::TUidMap::const_iterator it = model_.fncUids.find(uid);
+    if (model_.fncUids.end() == it) {
+        // not seen by the scan of cl_code_model_link()
+        err_ = true;
+        return 0;
+    }
+
+    return it->second;
+}
+
+struct cl_type* ModelReader::readType() {
+    if (!this->readBool())
+        return 0;
+
+    return this->typeByUid(this->readInt());
+}
+
+struct cl_operand* ModelReader::readOperand() {
+    const unsigned long code = this->readUnsigned();
+    if (!code)
+        // NULL
+        return 0;
+
+    struct cl_operand *op = new struct cl_operand();
+    model_.opList.push_back(op);
+    op->code    = static_cast<enum cl_operand_e>(code - 1);
+    op->scope   = static_cast<enum cl_scope_e>(this->readUnsigned());
+    op->type    = this->readType();
+
+    // read the chain of accessors
+    struct cl_accessor **pAc = &op->accessor;
+    for (unsigned long cntAc = this->readUnsigned(); !err_ && cntAc; --cntAc) {
+        struct cl_accessor *ac = new struct cl_accessor();
+        model_.acList.push_back(ac);
+        *pAc = ac;
+        pAc = &ac->next;
+
+        ac->code = static_cast<enum cl_accessor_e>(this->readUnsigned());
+        ac->type = this->readType();
+        switch (ac->code) {
+            case CL_ACCESSOR_DEREF_ARRAY:
+                ac->data.array.index = this->readOperand();
+                break;
+
+            case CL_ACCESSOR_ITEM:
+                ac->data.item.id = this->readInt();
+                break;
+
+            case CL_ACCESSOR_OFFSET:
+                ac->data.offset.off = this->readInt();
+                break;
+
+            case CL_ACCESSOR_REF:
+            case CL_ACCESSOR_DEREF:
+                break;
+
+            default:
+                err_ = true;
+        }
+    }
+
+    switch (op->code) {
+        case CL_OPERAND_VOID:
+            break;
+
+        case CL_OPERAND_VAR:
+            op->data.var = this->resolveVar(this->readInt(), op->scope);
+            break;
+
+        case CL_OPERAND_CST: {
+            struct cl_cst &cst = op->data.cst;
+            cst.code = static_cast<enum cl_type_e>(this->readUnsigned());
+            switch (cst.code) {
+                case CL_TYPE_FNC: {
+                    const int uid               = this->readInt();
+                    cst.data.cst_fnc.name       = this->readStr();
+                    cst.data.cst_fnc.is_extern  = this->readBool();
+                    this->readLoc(&cst.data.cst_fnc.loc);
+                    cst.data.cst_fnc.uid        = this->resolveFnc(uid,
+                            op->scope, cst.data.cst_fnc.name);
+                    break;
+                }
+
+                case CL_TYPE_STRING:
+                    cst.data.cst_string.value   = this->readStr();
+                    break;
+
+                case CL_TYPE_REAL:
+                    cst.data.cst_real.value     = this->readReal();
+                    break;
+
+                default:
+                    cst.data.cst_int.value      = this->readInt();
+                    break;
+            }
+            break;
+        }
+
+        default:
+            err_ = true;
+    }
+
+    return op;
+}
+
+void ModelReader::readInsn(struct cl_insn *cli) {
+    memset(cli, 0, sizeof *cli);
+    cli->code = static_cast<enum cl_insn_e>(this->readUnsigned());
+    this->readLoc(&cli->loc);
+    switch (cli->code) {
+        case CL_INSN_JMP:
+            cli->data.insn_jmp.label            = this->readStr();
+            break;
+
+        case CL_INSN_COND:
+            cli->data.insn_cond.src             = this->readOperand();
+            cli->data.insn_cond.then_label      = this->readStr();
+            cli->data.insn_cond.else_label      = this->readStr();
+            break;
+
+        case CL_INSN_RET:
+            cli->data.insn_ret.src              = this->readOperand();
+            break;
+
+        case CL_INSN_UNOP:
+            cli->data.insn_unop.code            =
+                static_cast<enum cl_unop_e>(this->readUnsigned());
+            cli->data.insn_unop.dst             = this->readOperand();
+            cli->data.insn_unop.src             = this->readOperand();
+            break;
+
+        case CL_INSN_BINOP:
+            cli->data.insn_binop.code           =
+                static_cast<enum cl_binop_e>(this->readUnsigned());
+            cli->data.insn_binop.dst            = this->readOperand();
+            cli->data.insn_binop.src1           = this->readOperand();
+            cli->data.insn_binop.src2           = this->readOperand();
+            break;
+
+        case CL_INSN_LABEL:
+            cli->data.insn_label.name           = this->readStr();
+            break;
+
+        case CL_INSN_NOP:
+        case CL_INSN_ABORT:
+            break;
+
+        default:
+            err_ = true;
+    }
+}
+
+void ModelReader::readStrDef() {
+    const unsigned long len = this->readUnsigned();
+    if (err_ || static_cast<unsigned long>(end_ - cur_) <= len || cur_[len]) {
+        // the string has to be terminated by zero within the mapped area
+        err_ = true;
+        return;
+    }
+
+    strTab_.push_back(reinterpret_cast<const char *>(cur_));
+    cur_ += len + /* trailing zero */ 1;
+}
+
+void ModelReader::readTypeDef() {
+    struct cl_type *clt = this->typeByUid(this->readInt());
+    clt->code           = static_cast<enum cl_type_e>(this->readUnsigned());
+    this->readLoc(&clt->loc);
+    clt->scope          = static_cast<enum cl_scope_e>(this->readUnsigned());
+    clt->name           = this->readStr();
+    clt->size           = this->readInt();
+
+    // the type may have been already defined by a previous replay
+    delete[] clt->items;
+    clt->items          = 0;
+    clt->item_cnt       = 0;
+
+    const unsigned long cnt = this->readUnsigned();
+    if (err_ || static_cast<unsigned long>(end_ - cur_) < cnt) {
+        // each item takes at least one byte
+        err_ = true;
+        return;
+    }
+
+    if (cnt)
+        clt->items = new struct cl_type_item[cnt];
+
+    clt->item_cnt = cnt;
+    for (unsigned long i = 0; i < cnt; ++i) {
+        struct cl_type_item *item = clt->items + i;
+        item->type      = this->readType();
+        item->name      = this->readStr();
+        item->offset    = this->readInt();
+    }
+
+    clt->array_size     = this->readInt();
+    clt->is_unsigned    = this->readBool();
+}
+
+void ModelReader::readVarDef() {
+    struct cl_var *var  = this->varByUid(this->readInt());
+    var->name           = this->readStr();
+    var->artificial     = this->readBool();
+    this->readLoc(&var->loc);
+    var->initialized    = this->readBool();
+    var->is_extern      = this->readBool();
+
+    // read the chain of initializers
+    var->initial = 0;
+    struct cl_initializer **pInit = &var->initial;
+    for (unsigned long cnt = this->readUnsigned(); !err_ && cnt; --cnt) {
+        struct cl_initializer *in = new struct cl_initializer();
+        model_.initList.push_back(in);
+        *pInit = in;
+        pInit = &in->next;
+        this->readInsn(&in->insn);
+    }
+}
+
+bool ModelReader::replay(struct cl_code_listener *cl) {
+    while (!err_ && cur_ < end_) {
+        const EDumpTag tag = static_cast<EDumpTag>(this->readByte());
+        switch (tag) {
+            case DT_STRING:
+                this->readStrDef();
+                break;
+
+            case DT_TYPE:
+                this->readTypeDef();
+                break;
+
+            case DT_VAR:
+                this->readVarDef();
+                break;
+
+            case DT_FILE_OPEN: {
+                const char *fileName = this->readStr();
+                if (!err_)
+                    cl->file_open(cl, fileName);
+                break;
+            }
+
+            case DT_FILE_CLOSE:
+                cl->file_close(cl);
+                break;
+
+            case DT_FNC_OPEN: {
+                const struct cl_operand *fnc = this->readOperand();
+                if (!err_)
+                    cl->fnc_open(cl, fnc);
+                break;
+            }
+
+            case DT_FNC_ARG_DECL: {
+                const int argId = this->readInt();
+                const struct cl_operand *arg = this->readOperand();
+                if (!err_)
+                    cl->fnc_arg_decl(cl, argId, arg);
+                break;
+            }
+
+            case DT_FNC_CLOSE:
+                cl->fnc_close(cl);
+                break;
+
+            case DT_BB_OPEN: {
+                const char *name = this->readStr();
+                if (!err_)
+                    cl->bb_open(cl, name);
+                break;
+            }
+
+            case DT_INSN: {
+                struct cl_insn cli;
+                this->readInsn(&cli);
+                if (!err_)
+                    cl->insn(cl, &cli);
+                break;
+            }
+
+            case DT_INSN_CALL_OPEN: {
+                struct cl_loc loc;
+                this->readLoc(&loc);
+                const struct cl_operand *dst = this->readOperand();
+                const struct cl_operand *fnc = this->readOperand();
+                if (!err_)
+                    cl->insn_call_open(cl, &loc, dst, fnc);
+                break;
+            }
+
+            case DT_INSN_CALL_ARG: {
+                const int argId = this->readInt();
+                const struct cl_operand *arg = this->readOperand();
+                if (!err_)
+                    cl->insn_call_arg(cl, argId, arg);
+                break;
+            }
+
+            case DT_INSN_CALL_CLOSE:
+                cl->insn_call_close(cl);
+                break;
+
+            case DT_INSN_SWITCH_OPEN: {
+                struct cl_loc loc;
+                this->readLoc(&loc);
+                const struct cl_operand *src = this->readOperand();
+                if (!err_)
+                    cl->insn_switch_open(cl, &loc, src);
+                break;
+            }
+
+            case DT_INSN_SWITCH_CASE: {
+                struct cl_loc loc;
+                this->readLoc(&loc);
+                const struct cl_operand *valLo = this->readOperand();
+                const struct cl_operand *valHi = this->readOperand();
+                const char *label = this->readStr();
+                if (!err_)
+                    cl->insn_switch_case(cl, &loc, valLo, valHi, label);
+                break;
+            }
+
+            case DT_INSN_SWITCH_CLOSE:
+                cl->insn_switch_close(cl);
+                break;
+
+            case DT_ACKNOWLEDGE:
+                // left up to the caller of cl_code_model_replay()
+                break;
+
+            default:
+                err_ = true;
+        }
+    }
+
+    if (err_)
+        CL_ERROR("corrupted code model '" << model_.fileName
+                << "' at offset " << (cur_ - beg_));
+
+    return !err_;
+}
+
+// /////////////////////////////////////////////////////////////////////////////
+// code model linker
+//
+// Each code model comes from a separate run of the compiler, so the uids are
+// unique only within a single model.  The linker gives new uids to types and
+// declarations of all the models, such that they are unique in the program.
+// Global variables and functions are resolved by name across the models,
+// global variables are then referred to by the cl_var object of the model that
+// defines them, so that their initializers are seen by the listener.
+class ModelLinker {
+    public:
+        ModelLinker():
+            lastUid_(0)
+        {
+        }
+
+        void link(struct cl_code_model *const models[], int cnt);
+
+    private:
+        typedef std::map<std::string, struct cl_var *>  TVarByName;
+        typedef std::map<std::string, int>              TUidByName;
+        typedef std::map<const struct cl_var *, int>    TUidByVar;
+
+        int                         lastUid_;
+        TVarByName                  glVars_;
+        TUidByName                  glFncs_;
+        TUidByVar                   uidByVar_;
+
+        struct cl_var* glVarOf(const cl_code_model &, int uid) const;
+        void pickGlVars(const cl_code_model &);
+        void linkDecls(cl_code_model &);
+        void linkTypes(cl_code_model &);
+};
+
+// return the cl_var object representing the global variable, 0 if not global
+struct cl_var* ModelLinker::glVarOf(const cl_code_model &model, int uid) const {
+    const cl_code_model::TScopeMap::const_iterator it =
+        model.varScopes.find(uid);
+    if (model.varScopes.end() == it || CL_SCOPE_GLOBAL != it->second)
+        return 0;
+
+    const struct cl_var *var = model.varMap.find(uid)->second;
+    if (!var->name)
+        return 0;
+
+    const TVarByName::const_iterator itGl = glVars_.find(var->name);
+    return (glVars_.end() == itGl)
+        ? 0
+        : itGl->second;
+}
+
+// prefer definitions to extern declarations, and initialized ones to the rest
+void ModelLinker::pickGlVars(const cl_code_model &model) {
+    BOOST_FOREACH(cl_code_model::TScopeMap::const_reference item,
+            model.varScopes)
+    {
+        if (CL_SCOPE_GLOBAL != item.second)
+            continue;
+
+        struct cl_var *var = model.varMap.find(item.first)->second;
+        if (!var->name)
+            continue;
+
+        struct cl_var *&pick = glVars_[var->name];
+        if (!pick || (pick->is_extern && !var->is_extern)) {
+            pick = var;
+            continue;
+        }
+
+        if (var->is_extern || pick == var)
+            continue;
+
+        if (!pick->initial) {
+            // a tentative definition
+            if (var->initial)
+                pick = var;
+
+            continue;
+        }
+
+        if (var->initial)
+            CL_WARN_MSG(&var->loc, "multiple definitions of global variable "
+                    << var->name << ", using the one from "
+                    << pick->loc.file);
+    }
+}
+
+void ModelLinker::linkDecls(cl_code_model &model) {
+    // the relative order of uids within the model is preserved
+    std::set<int> uids;
+    BOOST_FOREACH(cl_code_model::TVarMap::const_reference item, model.varMap)
+        uids.insert(item.first);
+    BOOST_FOREACH(cl_code_model::TScopeMap::const_reference item,
+            model.fncScopes)
+        uids.insert(item.first);
+
+    model.varLinks.clear();
+    model.fncUids.clear();
+
+    BOOST_FOREACH(const int uid, uids) {
+        const cl_code_model::TVarMap::const_iterator itVar =
+            model.varMap.find(uid);
+
+        if (model.varMap.end() != itVar) {
+            struct cl_var *var = this->glVarOf(model, uid);
+            if (!var)
+                // not visible out of the model
+                var = itVar->second;
+
+            int &progUid = uidByVar_[var];
+            if (!progUid)
+                progUid = ++lastUid_;
+
+            model.varLinks[uid] = var;
+            continue;
+        }
+
+        const char *name = model.fncNames[uid];
+        if (!name || CL_SCOPE_GLOBAL != model.fncScopes[uid]) {
+            // not visible out of the model
+            model.fncUids[uid] = ++lastUid_;
+            continue;
+        }
+
+        int &progUid = glFncs_[name];
+        if (!progUid)
+            progUid = ++lastUid_;
+
+        model.fncUids[uid] = progUid;
+    }
+}
+
+void ModelLinker::linkTypes(cl_code_model &model) {
+    BOOST_FOREACH(cl_code_model::TTypeMap::const_reference item, model.typeMap)
+        item.second->uid = ++lastUid_;
+}
+
+void ModelLinker::link(struct cl_code_model *const models[], int cnt) {
+    for (int i = 0; i < cnt; ++i)
+        this->pickGlVars(*models[i]);
+
+    for (int i = 0; i < cnt; ++i)
+        this->linkDecls(*models[i]);
+
+    // the cl_var objects get the new uids once all the models are linked
+    for (int i = 0; i < cnt; ++i) {
+        cl_code_model &model = *models[i];
+        BOOST_FOREACH(cl_code_model::TVarMap::const_reference item,
+                model.varLinks)
+        {
+            struct cl_var *var = model.varMap[item.first];
+            var->uid = uidByVar_[item.second];
+        }
+
+        this->linkTypes(model);
+        model.linked = true;
+    }
+}
+
+// /////////////////////////////////////////////////////////////////////////////
+// public interface, see cl_dump.hh for more details
+ICodeListener* createClDump(const char *fileName) {
+    if (!fileName || !*fileName) {
+        CL_ERROR("no file name given to the \"dump\" code listener");
+        return 0;
+    }
+
+    ClDump *cl = new ClDump(fileName);
+    if (cl->isOk())
+        return cl;
+
+    delete cl;
+    return 0;
+}
+
+struct cl_code_model* cl_code_model_load(const char *file_name) {
+    const int fd = open(file_name, O_RDONLY);
+    if (fd < 0) {
+        CL_ERROR("unable to open file '" << file_name << "'");
+        return 0;
+    }
+
+    struct stat st;
+    void *addr = MAP_FAILED;
+    if (!fstat(fd, &st) && static_cast<off_t>(sizeof dumpMagic) <= st.st_size)
+        addr = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // the mapping (if any) remains valid after the file is closed
+    close(fd);
+
+    if (MAP_FAILED == addr) {
+        CL_ERROR("unable to map file '" << file_name << "'");
+        return 0;
+    }
+
+    if (memcmp(addr, dumpMagic, sizeof dumpMagic)) {
+        CL_ERROR("'" << file_name << "' is not a code model of matching version");
+        munmap(addr, st.st_size);
+        return 0;
+    }
+
+    try {
+        struct cl_code_model *model = new struct cl_code_model;
+        model->fileName = file_name;
+        model->base     = static_cast<const unsigned char *>(addr);
+        model->size     = st.st_size;
+        return model;
+    }
+    catch (...) {
+        CL_DIE("uncaught exception in cl_code_model_load()");
+    }
+}
+
+bool cl_code_model_replay(
+        struct cl_code_model            *model,
+        struct cl_code_listener         *listener)
+{
+    try {
+        ModelReader reader(*model);
+        return reader.replay(listener);
+    }
+    catch (...) {
+        CL_DIE("uncaught exception in cl_code_model_replay()");
+    }
+}
+
+bool cl_code_model_link(
+        struct cl_code_model            *const models[],
+        int                             cnt,
+        struct cl_code_listener         *listener)
+{
+    if (1 == cnt)
+        // nothing to link, keep the uids as they are
+        return cl_code_model_replay(models[0], listener);
+
+    try {
+        // scan the declarations of all the models
+        struct cl_code_listener *sink = cl_chain_create();
+        bool ok = true;
+        for (int i = 0; ok && i < cnt; ++i) {
+            cl_code_model &model = *models[i];
+            model.linked = false;
+            ModelReader reader(model, /* scan */ true);
+            ok = reader.replay(sink);
+        }
+
+        if (!ok) {
+            sink->destroy(sink);
+            return false;
+        }
+
+        ModelLinker linker;
+        linker.link(models, cnt);
+
+        // a global var may be used by a model replayed before the one defining
+        // it, so re-read the initializers of all the models with linked uids
+        // first, otherwise they would still refer to the per-model uids
+        for (int i = 0; ok && i < cnt; ++i) {
+            ModelReader reader(*models[i]);
+            ok = reader.replay(sink);
+        }
+
+        sink->destroy(sink);
+
+        for (int i = 0; ok && i < cnt; ++i) {
+            ModelReader reader(*models[i]);
+            ok = reader.replay(listener);
+        }
+
+        return ok;
+    }
+    catch (...) {
+        CL_DIE("uncaught exception in cl_code_model_link()");
+    }
+}
+
+void cl_code_model_free(struct cl_code_model *model) {
+    BOOST_FOREACH(cl_code_model::TTypeMap::const_reference item,
+            model->typeMap)
+    {
+        struct cl_type *clt = item.second;
+        delete[] clt->items;
+        delete clt;
+    }
+
+    BOOST_FOREACH(cl_code_model::TVarMap::const_reference item, model->varMap)
+        delete item.second;
+
+    BOOST_FOREACH(struct cl_operand *op, model->opList)
+        delete op;
+
+    BOOST_FOREACH(struct cl_accessor *ac, model->acList)
+        delete ac;
+
+    BOOST_FOREACH(struct cl_initializer *in, model->initList)
+        delete in;
+
+    munmap(const_cast<unsigned char *>(model->base), model->size);
+    delete model;
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2012 Kamil Dudka <kdudka@redhat.com>
+ *
+ * This file is part of predator.
+ *
+ * predator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * predator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with predator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_GUARD_CL_DUMP_H
+#define H_GUARD_CL_DUMP_H
+
+/**
+ * @file cl_dump.hh
+ * constructor createClDump() of the @b "dump" code listener
+ */
+
+class ICodeListener;
+
+/**
+ * create "dump" ICodeListener implementation, which serializes the complete
+ * code model (types, variables, functions, CFGs, operands and locations) into
+ * a compact binary file.  The file can be loaded back by cl_code_model_load()
+ * and replayed into any other code listener without running the compiler.
+ * @param fileName Name of the file to write to (mandatory).
+ */
+ICodeListener* createClDump(const char *fileName);
+
+#endif /* H_GUARD_CL_DUMP_H */
@@ -19,7 +19,6 @@
 
 #include "config_cl.h"
 
-#define __CL_IN
 #include "cl_easy.hh"
 
 #include <cl/cl_msg.hh>
@@ -28,8 +27,10 @@
 
 #include "callgraph.hh"
 #include "cl_storage.hh"
+#include "constprop.hh"
 #include "killer.hh"
 #include "loopscan.hh"
+#include "slicer.hh"
 #include "stopwatch.hh"
 
 #include <string>
@@ -58,6 +59,14 @@ class ClEasy: public ClStorageBuilder {
                 return;
             }
 
+#if CL_EASY_FOLD_CONST_CONDS
+            CL_DEBUG("folding conditions with known outcome...");
+            foldConstConditions(stor);
+#endif
+#if CL_EASY_SLICE_INSNS
+            CL_DEBUG("slicing out instructions irrelevant for the heap...");
+            sliceIrrelevantInsns(stor);
+#endif
             CL_DEBUG("building call-graph...");
             CodeStorage::CallGraph::buildCallGraph(stor);
 
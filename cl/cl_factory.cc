@@ -22,6 +22,7 @@
 #include <cl/cl_msg.hh>
 
 #include "cl_dotgen.hh"
+#include "cl_dump.hh"
 #include "cl_easy.hh"
 #include "cl_factory.hh"
 #include "cl_locator.hh"
@@ -295,6 +296,7 @@ ClFactory::ClFactory():
     d(new Private)
 {
     d->map["dotgen"]        = &createClDotGenerator;
+    d->map["dump"]          = &createClDump;
     d->map["easy"]          = &createClEasy;
     d->map["locator"]       = &createClLocator;
     d->map["pp"]            = &createClPrettyPrintDef;
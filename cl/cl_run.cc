@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2012 Kamil Dudka <kdudka@redhat.com>
+ *
+ * This file is part of predator.
+ *
+ * predator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * predator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with predator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file cl_run.cc
+ * standalone runner of an analyzer linked in statically, shared by predator-run
+ * and forester-run, see cl_code_model_run() for details
+ */
+
+#include "config_cl.h"
+
+#include <cl/code_listener.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+// creates the listener running the analyzer, as given to cl_code_model_run()
+static cl_code_listener_factory listenerFactory;
+
+static int cntErrors;
+
+static void countError(const char *msg)
+{
+    fprintf(stderr, "%s\n", msg);
+    ++cntErrors;
+}
+
+static void printMsg(const char *msg)
+{
+    fprintf(stderr, "%s\n", msg);
+}
+
+static void printDie(const char *msg)
+{
+    fprintf(stderr, "%s\n", msg);
+    exit(EXIT_FAILURE);
+}
+
+static void usage(const char *self)
+{
+    fprintf(stderr, "Usage: %s [-v VERBOSITY_LEVEL] [-a ANALYZER_ARGS] "
+            "MODEL_FILE...\n", self);
+    fprintf(stderr, "       %s [-v VERBOSITY_LEVEL] -s SOCKET [-j WORKERS]\n",
+            self);
+}
+
+// escape the given string to be used as a value within config_string
+static std::string escapeValue(const char *str)
+{
+    std::string val;
+    for (; *str; ++str) {
+        if ('"' == *str || '\\' == *str)
+            val.push_back('\\');
+
+        val.push_back(*str);
+    }
+
+    return val;
+}
+
+typedef std::vector<struct cl_code_model *> TModelList;
+
+static void freeModels(const TModelList &models)
+{
+    for (unsigned i = 0; i < models.size(); ++i)
+        cl_code_model_free(models[i]);
+}
+
+// run the analyzer over the given code models
+static int runModels(int cnt, const char *const files[], const char *args)
+{
+    cntErrors = 0;
+
+    // load all the code models first, they have to outlive the listener
+    TModelList models;
+    for (int i = 0; i < cnt; ++i) {
+        struct cl_code_model *model = cl_code_model_load(files[i]);
+        if (!model) {
+            freeModels(models);
+            return EXIT_FAILURE;
+        }
+
+        models.push_back(model);
+    }
+
+    // use the same filters as the gcc plug-in does for the analyzer
+    const std::string cnf = "listener=\"easy\" listener_args=\""
+        + escapeValue(args)
+        + "\" clf=\"unfold_switch,unify_labels_gl\"";
+
+    struct cl_code_listener *cl = listenerFactory(cnf.c_str());
+    if (!cl) {
+        freeModels(models);
+        return EXIT_FAILURE;
+    }
+
+    // each model comes from a separate run of gcc, link them into one program
+    const bool ok = cl_code_model_link(&models[0], models.size(), cl);
+
+    if (ok && !cntErrors)
+        // this triggers the analysis
+        cl->acknowledge(cl);
+
+    cl->destroy(cl);
+    freeModels(models);
+
+    return (ok && !cntErrors)
+        ? EXIT_SUCCESS
+        : EXIT_FAILURE;
+}
+
+// called by cl_code_model_serve() in a forked worker per each request
+static int serveModel(const char *modelFile, const char *args)
+{
+    return runModels(1, &modelFile, args);
+}
+
+int cl_code_model_run(
+        int                             argc,
+        char                            *argv[],
+        cl_code_listener_factory        factory)
+{
+    listenerFactory = factory;
+
+    int verbose = 0;
+    int workers = 1;
+    const char *analyzerArgs = "";
+    const char *socketPath = 0;
+
+    int opt;
+    while (-1 != (opt = getopt(argc, argv, "a:j:s:v:"))) {
+        switch (opt) {
+            case 'a':
+                analyzerArgs = optarg;
+                break;
+
+            case 'j':
+                workers = atoi(optarg);
+                break;
+
+            case 's':
+                socketPath = optarg;
+                break;
+
+            case 'v':
+                verbose = atoi(optarg);
+                break;
+
+            default:
+                usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if ((socketPath) ? (optind < argc) : (argc <= optind)) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    struct cl_init_data init = {
+        printMsg,               // .debug
+        printMsg,               // .warn
+        countError,             // .error
+        printMsg,               // .note
+        printDie,               // .die
+        verbose                 // .debug_level
+    };
+    cl_global_init(&init);
+
+    const int rv = (socketPath)
+        ? cl_code_model_serve(socketPath, workers, serveModel)
+        : runModels(argc - optind, argv + optind, analyzerArgs);
+
+    cl_global_cleanup();
+    return rv;
+}
@@ -0,0 +1,559 @@
+/*
+ * Copyright (C) 2012 Kamil Dudka <kdudka@redhat.com>
+ *
+ * This file is part of predator.
+ *
+ * predator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * predator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with predator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file cl_server.cc
+ * analysis server serving code models over a Unix domain socket
+ *
+ * The protocol is trivial.  The client sends a line with analyzer args, a line
+ * with size of the code model in bytes and the code model itself.  The server
+ * then sends anything the analysis has written to stderr, followed by a zero
+ * byte and the exit status of the analysis as a decimal number.
+ *
+ * Each request is analyzed in a worker forked from the server, so that no state
+ * of the analysis leaks from one request to another.  The server remembers the
+ * results of the analyses it has run, keyed by the analyzer args and the code
+ * model, and answers a request for an unchanged code model without forking.
+ */
+
+#include "config_cl.h"
+
+#include <cl/cl_msg.hh>
+#include <cl/code_listener.h>
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <string>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+/// how often (in ms) the server looks for finished workers while idle
+const int serverPollTimeout = 100;
+
+/// how long (in s) the server waits for a stalled client to send the request
+const int serverRecvTimeout = 30;
+
+volatile sig_atomic_t serverDone;
+
+void onTermSignal(int)
+{
+    serverDone = 1;
+}
+
+bool writeAll(int fd, const void *buf, size_t len)
+{
+    const char *ptr = static_cast<const char *>(buf);
+    while (len) {
+        const ssize_t rv = write(fd, ptr, len);
+        if (rv < 0 && EINTR == errno)
+            continue;
+        if (rv <= 0)
+            return false;
+
+        ptr += rv;
+        len -= rv;
+    }
+
+    return true;
+}
+
+bool readLine(int fd, std::string &dst)
+{
+    dst.clear();
+    for (;;) {
+        char c;
+        const ssize_t rv = read(fd, &c, 1);
+        if (rv < 0 && EINTR == errno)
+            continue;
+        if (rv <= 0)
+            return false;
+        if ('\n' == c)
+            return true;
+
+        dst.push_back(c);
+    }
+}
+
+bool readData(int fd, std::string &dst, size_t len)
+{
+    char buf[0x10000];
+    while (len) {
+        size_t chunk = sizeof buf;
+        if (len < chunk)
+            chunk = len;
+
+        const ssize_t rv = read(fd, buf, chunk);
+        if (rv < 0 && EINTR == errno)
+            continue;
+        if (rv <= 0)
+            return false;
+
+        dst.append(buf, rv);
+        len -= rv;
+    }
+
+    return true;
+}
+
+bool readFile(const char *fileName, std::string &dst)
+{
+    const int fd = open(fileName, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st)) {
+        if (0 <= fd)
+            close(fd);
+
+        return false;
+    }
+
+    const bool ok = readData(fd, dst, st.st_size);
+    close(fd);
+    return ok;
+}
+
+bool writeFile(const char *fileName, const std::string &data)
+{
+    const int fd = open(fileName, O_WRONLY | O_TRUNC);
+    if (fd < 0)
+        return false;
+
+    const bool ok = writeAll(fd, data.data(), data.size());
+    return !close(fd) && ok;
+}
+
+bool copyData(int dst, int src, size_t len)
+{
+    char buf[0x10000];
+    while (len) {
+        size_t chunk = sizeof buf;
+        if (len < chunk)
+            chunk = len;
+
+        const ssize_t rv = read(src, buf, chunk);
+        if (rv < 0 && EINTR == errno)
+            continue;
+        if (rv <= 0 || !writeAll(dst, buf, rv))
+            return false;
+
+        len -= rv;
+    }
+
+    return true;
+}
+
+bool initSockAddr(struct sockaddr_un *addr, const char *socket_path)
+{
+    memset(addr, 0, sizeof *addr);
+    addr->sun_family = AF_UNIX;
+    if (sizeof addr->sun_path <= strlen(socket_path)) {
+        CL_ERROR("socket path too long: " << socket_path);
+        return false;
+    }
+
+    strcpy(addr->sun_path, socket_path);
+    return true;
+}
+
+// read the request, the key consists of the analyzer args and the code model
+bool readRequest(int conn, std::string &args, std::string &key)
+{
+    struct timeval tv;
+    tv.tv_sec = serverRecvTimeout;
+    tv.tv_usec = 0;
+    setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof tv);
+
+    std::string size;
+    if (!readLine(conn, args) || !readLine(conn, size))
+        return false;
+
+    key = args;
+    key.push_back('\n');
+    return readData(conn, key, strtoul(size.c_str(), 0, 10));
+}
+
+// send the messages of the analysis to the client, followed by the trailer
+void sendResult(int conn, const std::string &output, int rv)
+{
+    char trailer[0x10];
+    const int len = snprintf(trailer, sizeof trailer, "%c%d", '\0', rv);
+
+    // the client may have gone away meanwhile, nothing to do about it
+    (void) (writeAll(conn, output.data(), output.size())
+            && writeAll(conn, trailer, len));
+}
+
+struct CachedResult {
+    std::string                         output;
+    int                                 status;
+};
+
+/// results of the analyses, the oldest one is dropped first
+class ResultCache {
+    public:
+        const CachedResult* lookup(const std::string &key) const {
+            const TMap::const_iterator it = map_.find(key);
+            return (map_.end() == it)
+                ? 0
+                : &it->second;
+        }
+
+        void insert(const std::string &key, const CachedResult &result) {
+            if (CL_SERVER_CACHE_SIZE <= 0)
+                return;
+
+            const std::pair<TMap::iterator, bool> rv =
+                map_.insert(TMap::value_type(key, result));
+            if (!rv.second)
+                // the same request has been analyzed concurrently
+                return;
+
+            fifo_.push_back(rv.first);
+            if (static_cast<int>(fifo_.size()) <= CL_SERVER_CACHE_SIZE)
+                return;
+
+            map_.erase(fifo_.front());
+            fifo_.pop_front();
+        }
+
+    private:
+        typedef std::map<std::string, CachedResult>     TMap;
+
+        TMap                            map_;
+        std::deque<TMap::iterator>      fifo_;
+};
+
+// runs in the forked worker
+int handleRequest(
+        const char                      *modelFile,
+        const char                      *outFile,
+        const char                      *args,
+        cl_code_model_handler           handler)
+{
+    // all messages of the analysis go to the output file read by the server
+    const int fd = open(outFile, O_WRONLY | O_TRUNC);
+    if (fd < 0) {
+        CL_ERROR("failed to open output file of analysis server");
+        return EXIT_FAILURE;
+    }
+
+    fflush(stderr);
+    dup2(fd, STDERR_FILENO);
+    close(fd);
+
+    const int rv = handler(modelFile, args);
+    fflush(0);
+    return rv;
+}
+
+struct Worker {
+    int                                 conn;
+    std::string                         key;
+    std::string                         modelFile;
+    std::string                         outFile;
+};
+
+typedef std::map<pid_t, Worker>         TWorkers;
+
+// send the result to the client, remember it, and release the worker
+void reapWorker(TWorkers &workers, ResultCache &cache, pid_t pid, int status)
+{
+    TWorkers::iterator it = workers.find(pid);
+    if (workers.end() == it)
+        return;
+
+    Worker &wrk = it->second;
+
+    CachedResult result;
+    result.status = (WIFEXITED(status))
+        ? WEXITSTATUS(status)
+        : 128 + WTERMSIG(status);
+
+    const bool ok = readFile(wrk.outFile.c_str(), result.output);
+    sendResult(wrk.conn, result.output, result.status);
+
+    if (ok && WIFEXITED(status))
+        // a worker killed by a signal might give another result next time
+        cache.insert(wrk.key, result);
+
+    close(wrk.conn);
+    unlink(wrk.modelFile.c_str());
+    unlink(wrk.outFile.c_str());
+    workers.erase(it);
+}
+
+void reapWorkers(TWorkers &workers, ResultCache &cache, bool block)
+{
+    int status;
+    pid_t pid;
+    while (0 < (pid = waitpid(-1, &status, (block) ? 0 : WNOHANG))) {
+        reapWorker(workers, cache, pid, status);
+        block = false;
+    }
+}
+
+bool createTmpFile(char *name)
+{
+    const int fd = mkstemp(name);
+    if (fd < 0)
+        return false;
+
+    close(fd);
+    return true;
+}
+
+void startWorker(
+        TWorkers                        &workers,
+        const ResultCache               &cache,
+        int                             sock,
+        int                             conn,
+        cl_code_model_handler           handler)
+{
+    std::string args, key;
+    if (!readRequest(conn, args, key)) {
+        CL_ERROR("malformed request received by analysis server");
+        close(conn);
+        return;
+    }
+
+    const CachedResult *cached = cache.lookup(key);
+    if (cached) {
+        CL_DEBUG("analysis server reuses the result of a previous request");
+        sendResult(conn, cached->output, cached->status);
+        close(conn);
+        return;
+    }
+
+    // created by the server, so that they can be removed even if worker dies
+    char modelFile[] = "/tmp/cl-model-XXXXXX";
+    char outFile[] = "/tmp/cl-output-XXXXXX";
+    const bool haveModel = createTmpFile(modelFile);
+    const bool haveOut = haveModel && createTmpFile(outFile);
+    if (!haveOut || !writeFile(modelFile, key.substr(args.size() + 1))) {
+        CL_ERROR("failed to create temporary files for analysis server");
+        if (haveModel)
+            unlink(modelFile);
+        if (haveOut)
+            unlink(outFile);
+
+        close(conn);
+        return;
+    }
+
+    const pid_t pid = fork();
+    if (pid < 0) {
+        CL_ERROR("fork() failed while starting a worker");
+        unlink(modelFile);
+        unlink(outFile);
+        close(conn);
+        return;
+    }
+
+    if (!pid) {
+        // worker, it does not talk to the clients at all, the connections have
+        // to be closed so that only the server decides when they are finished
+        close(sock);
+        close(conn);
+        for (TWorkers::const_iterator it = workers.begin();
+                it != workers.end(); ++it)
+            close(it->second.conn);
+
+        signal(SIGINT,  SIG_DFL);
+        signal(SIGTERM, SIG_DFL);
+        _exit(handleRequest(modelFile, outFile, args.c_str(), handler));
+    }
+
+    Worker &wrk = workers[pid];
+    wrk.conn = conn;
+    wrk.key.swap(key);
+    wrk.modelFile = modelFile;
+    wrk.outFile = outFile;
+}
+
+} // namespace
+
+int cl_code_model_serve(
+        const char                      *socket_path,
+        int                             workers,
+        cl_code_model_handler           handler)
+{
+    if (workers < 1)
+        workers = 1;
+
+    struct sockaddr_un addr;
+    if (!initSockAddr(&addr, socket_path))
+        return EXIT_FAILURE;
+
+    const int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0) {
+        CL_ERROR("failed to create socket");
+        return EXIT_FAILURE;
+    }
+
+    unlink(socket_path);
+    if (bind(sock, reinterpret_cast<struct sockaddr *>(&addr), sizeof addr)
+            || listen(sock, workers))
+    {
+        CL_ERROR("failed to listen on " << socket_path);
+        close(sock);
+        return EXIT_FAILURE;
+    }
+
+    // let poll() be interrupted on termination request
+    struct sigaction sa;
+    memset(&sa, 0, sizeof sa);
+    sa.sa_handler = onTermSignal;
+    sigaction(SIGINT,  &sa, 0);
+    sigaction(SIGTERM, &sa, 0);
+
+    // a client going away must not kill the server (nor workers)
+    signal(SIGPIPE, SIG_IGN);
+
+    CL_DEBUG("analysis server listening on " << socket_path
+            << " with " << workers << " worker(s)");
+
+    TWorkers wrkMap;
+    ResultCache cache;
+    serverDone = 0;
+    while (!serverDone) {
+        // wait for a free slot if all the workers are busy
+        const bool full = (static_cast<int>(wrkMap.size()) >= workers);
+        reapWorkers(wrkMap, cache, full);
+        if (full)
+            continue;
+
+        struct pollfd pfd;
+        pfd.fd = sock;
+        pfd.events = POLLIN;
+        if (poll(&pfd, 1, serverPollTimeout) <= 0)
+            continue;
+
+        const int conn = accept(sock, 0, 0);
+        if (conn < 0)
+            continue;
+
+        startWorker(wrkMap, cache, sock, conn, handler);
+    }
+
+    CL_DEBUG("analysis server is shutting down, waiting for "
+            << wrkMap.size() << " worker(s)");
+
+    while (!wrkMap.empty())
+        reapWorkers(wrkMap, cache, /* block */ true);
+
+    close(sock);
+    unlink(socket_path);
+    return EXIT_SUCCESS;
+}
+
+int cl_code_model_submit(
+        const char                      *socket_path,
+        const char                      *model_file,
+        const char                      *args)
+{
+    if (strchr(args, '\n')) {
+        CL_ERROR("newline not allowed in analyzer args sent to server");
+        return -1;
+    }
+
+    const int fd = open(model_file, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st)) {
+        CL_ERROR("unable to open file '" << model_file << "'");
+        if (0 <= fd)
+            close(fd);
+        return -1;
+    }
+
+    struct sockaddr_un addr;
+    const int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0 || !initSockAddr(&addr, socket_path)
+            || connect(sock, reinterpret_cast<struct sockaddr *>(&addr),
+                       sizeof addr))
+    {
+        CL_ERROR("unable to connect to analysis server at " << socket_path);
+        if (0 <= sock)
+            close(sock);
+        close(fd);
+        return -1;
+    }
+
+    char size[0x20];
+    snprintf(size, sizeof size, "%lu\n",
+             static_cast<unsigned long>(st.st_size));
+
+    const std::string header = std::string(args) + "\n" + size;
+    const bool sent = writeAll(sock, header.data(), header.size())
+        && copyData(sock, fd, st.st_size);
+
+    close(fd);
+    if (!sent) {
+        CL_ERROR("failed to send code model to analysis server");
+        close(sock);
+        return -1;
+    }
+
+    // forward the messages until the zero byte, then read the exit status
+    bool inTrailer = false;
+    std::string status;
+    for (;;) {
+        char buf[0x1000];
+        const ssize_t rv = read(sock, buf, sizeof buf);
+        if (rv < 0 && EINTR == errno)
+            continue;
+        if (rv <= 0)
+            break;
+
+        const char *beg = buf;
+        const char *end = buf + rv;
+        if (!inTrailer) {
+            const char *nul = static_cast<const char *>(memchr(beg, 0, rv));
+            const char *msgEnd = (nul) ? nul : end;
+            fwrite(beg, 1, msgEnd - beg, stderr);
+            if (!nul)
+                continue;
+
+            inTrailer = true;
+            beg = nul + 1;
+        }
+
+        status.append(beg, end);
+    }
+
+    close(sock);
+    if (!inTrailer || status.empty()) {
+        CL_ERROR("analysis server closed the connection unexpectedly");
+        return -1;
+    }
+
+    return atoi(status.c_str());
+}
@@ -30,8 +30,11 @@
 namespace CodeStorage {
     struct Storage;
     struct Insn;
+    class Block;
 
+    void releaseOperand(struct cl_operand &ref);
     void destroyInsn(Insn *insn);
+    void destroyBlock(Block *bb);
 }
 
 /**
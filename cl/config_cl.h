@@ -45,6 +45,14 @@
  */
 #define CL_DEBUG_LOCATION               0
 
+/**
+ * debug level of the constant propagation
+ * - 0 ... print only time elapsed and count of folded conditions
+ * - 1 ... print conditions being folded and blocks being removed
+ * - 2 ... print some basic progress info
+ */
+#define CL_DEBUG_CONST_PROP             0
+
 /**
  * debug level of the CFG loop scanner
  * - 0 ... print only time elapsed
@@ -53,6 +61,14 @@
  */
 #define CL_DEBUG_LOOP_SCAN              0
 
+/**
+ * debug level of the heap-relevance slicer
+ * - 0 ... print only time elapsed and count of removed instructions
+ * - 1 ... print instructions being removed
+ * - 2 ... print some basic progress info
+ */
+#define CL_DEBUG_SLICER                 0
+
 /**
  * debug level of the verbose output when killing variables
  * - 0 ... print only time elapsed
@@ -68,11 +84,35 @@
  */
 #define CL_EASY_TIMER                   1
 
+/**
+ * if 1, fold conditions with known outcome and remove unreachable blocks before
+ * the analyzer is called (see constprop.hh)
+ * @note off by default, the expected outputs of the tests have not been
+ * checked with the folding enabled yet
+ */
+#define CL_EASY_FOLD_CONST_CONDS        0
+
+/**
+ * if 1, remove instructions that cannot influence pointers, memory accesses,
+ * conditions, nor calls before the analyzer is called (see slicer.hh)
+ * @note the slicer runs after the folding of constant conditions (if
+ * enabled), but before the call graph is built
+ * @note off by default, the expected outputs of the tests have not been
+ * checked with the slicer enabled yet
+ */
+#define CL_EASY_SLICE_INSNS             0
+
 /**
  * if 1, filter out repeated error/warning messages (sort of 2>&1 | uniq)
  */
 #define CL_MSG_SQUEEZE_REPEATS          1
 
+/**
+ * count of analysis results the server started by cl_code_model_serve() keeps
+ * for the requests to come, zero disables reuse of the results
+ */
+#define CL_SERVER_CACHE_SIZE            0x20
+
 /**
  * if 1, do not check for unused local variables and registers
  */
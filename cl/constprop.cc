@@ -0,0 +1,408 @@
+/*
+ * Copyright (C) 2012 Kamil Dudka <kdudka@redhat.com>
+ *
+ * This file is part of predator.
+ *
+ * predator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * predator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with predator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "config_cl.h"
+#include "constprop.hh"
+
+#include <cl/cl_msg.hh>
+#include <cl/cldebug.hh>
+#include <cl/clutil.hh>
+#include <cl/storage.hh>
+
+#include "cl_storage.hh"
+#include "stopwatch.hh"
+#include "util.hh"
+
+#include <climits>
+#include <map>
+#include <set>
+#include <stack>
+
+#include <boost/foreach.hpp>
+
+static int debugConstProp = CL_DEBUG_CONST_PROP;
+
+#define CP_DEBUG(level, ...) do {                                           \
+    if ((level) <= ::debugConstProp)                                        \
+        CL_DEBUG("ConstProp: " << __VA_ARGS__);                             \
+} while (0)
+
+#define CP_DEBUG_MSG(level, lw, ...) do {                                   \
+    if ((level) <= ::debugConstProp)                                        \
+        CL_DEBUG_MSG(lw, "ConstProp: " << __VA_ARGS__);                     \
+} while (0)
+
+namespace CodeStorage {
+
+namespace ConstProp {
+
+typedef const struct cl_loc                *TLoc;
+typedef const Block                        *TBlock;
+typedef const Insn                         *TInsn;
+typedef int                                 TVar;
+typedef long long                           TValue;
+
+/// known values of variables, the value of a variable not in the map is unknown
+typedef std::map<TVar, int>                 TState;
+typedef std::map<TBlock, TState>            TStateMap;
+
+/// index of the target taken by a conditional jump with known outcome
+typedef std::map<TInsn, unsigned>           TDecisions;
+
+typedef std::set<const Block *>             TBlockSet;
+
+static const int INT_BITS = CHAR_BIT * sizeof(int);
+
+bool isIntegral(const struct cl_type *clt) {
+    const enum cl_type_e code = clt->code;
+    switch (code) {
+        case CL_TYPE_INT:
+        case CL_TYPE_CHAR:
+        case CL_TYPE_BOOL:
+        case CL_TYPE_ENUM:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+/// true if the value can be stored in a variable of the given integral type
+bool fitsType(const struct cl_type *clt, const TValue val) {
+    if (CL_TYPE_BOOL == clt->code)
+        return (0 == val || 1 == val);
+
+    TValue lo = INT_MIN;
+    TValue hi = INT_MAX;
+    if (0 < clt->size && clt->size < static_cast<int>(sizeof(int))) {
+        const int bits = CHAR_BIT * clt->size;
+        lo = -(1LL << (bits - 1));
+        hi =  (1LL << (bits - 1)) - 1LL;
+        if (clt->is_unsigned)
+            hi = (1LL << bits) - 1LL;
+    }
+
+    if (clt->is_unsigned)
+        // values we cannot represent by int are treated as unknown
+        lo = 0LL;
+
+    return (lo <= val && val <= hi);
+}
+
+/// true if we track the value of the variable the operand refers to
+bool isTracked(const Storage &stor, const cl_operand &op) {
+    if (op.accessor || !isLcVar(op) || !isIntegral(op.type))
+        return false;
+
+    // the variable cannot change behind our back if nobody points to it
+    return !stor.vars[varIdFromOperand(&op)].mayBePointed;
+}
+
+bool readOperand(TValue *pDst, const TState &state, const cl_operand &op) {
+    switch (op.code) {
+        case CL_OPERAND_CST:
+            if (CL_TYPE_INT != op.data.cst.code || !isIntegral(op.type))
+                return false;
+
+            *pDst = op.data.cst.data.cst_int.value;
+            return fitsType(op.type, *pDst);
+
+        case CL_OPERAND_VAR:
+            if (op.accessor || !isLcVar(op))
+                return false;
+            break;
+
+        default:
+            return false;
+    }
+
+    const TState::const_iterator it = state.find(varIdFromOperand(&op));
+    if (state.end() == it)
+        return false;
+
+    *pDst = it->second;
+    return true;
+}
+
+bool evalUnop(TValue *pDst, const enum cl_unop_e code, const TValue val) {
+    switch (code) {
+        case CL_UNOP_ASSIGN:    *pDst = val;                    return true;
+        case CL_UNOP_TRUTH_NOT: *pDst = !val;                   return true;
+        case CL_UNOP_BIT_NOT:   *pDst = ~val;                   return true;
+        case CL_UNOP_MINUS:     *pDst = -val;                   return true;
+        case CL_UNOP_ABS:       *pDst = (val < 0) ? -val : val; return true;
+
+        default:
+            return false;
+    }
+}
+
+bool evalBinop(
+        TValue                     *pDst,
+        const enum cl_binop_e       code,
+        const TValue                a,
+        const TValue                b)
+{
+    switch (code) {
+        case CL_BINOP_EQ:           *pDst = (a == b);           return true;
+        case CL_BINOP_NE:           *pDst = (a != b);           return true;
+        case CL_BINOP_LT:           *pDst = (a <  b);           return true;
+        case CL_BINOP_GT:           *pDst = (a >  b);           return true;
+        case CL_BINOP_LE:           *pDst = (a <= b);           return true;
+        case CL_BINOP_GE:           *pDst = (a >= b);           return true;
+        case CL_BINOP_TRUTH_AND:    *pDst = (a && b);           return true;
+        case CL_BINOP_TRUTH_OR:     *pDst = (a || b);           return true;
+        case CL_BINOP_TRUTH_XOR:    *pDst = (!a != !b);         return true;
+        case CL_BINOP_PLUS:         *pDst = a + b;              return true;
+        case CL_BINOP_MINUS:        *pDst = a - b;              return true;
+        case CL_BINOP_MULT:         *pDst = a * b;              return true;
+        case CL_BINOP_MIN:          *pDst = (a < b) ? a : b;    return true;
+        case CL_BINOP_MAX:          *pDst = (a < b) ? b : a;    return true;
+        case CL_BINOP_BIT_AND:      *pDst = a & b;              return true;
+        case CL_BINOP_BIT_IOR:      *pDst = a | b;              return true;
+        case CL_BINOP_BIT_XOR:      *pDst = a ^ b;              return true;
+
+        case CL_BINOP_EXACT_DIV:
+        case CL_BINOP_TRUNC_DIV:
+        case CL_BINOP_TRUNC_MOD:
+            if (!b)
+                // division by zero is up to the analyzer to report
+                return false;
+
+            *pDst = (CL_BINOP_TRUNC_MOD == code)
+                ? (a % b)
+                : (a / b);
+            return true;
+
+        case CL_BINOP_LSHIFT:
+        case CL_BINOP_RSHIFT:
+            if (a < 0 || b < 0 || static_cast<TValue>(INT_BITS) <= b)
+                // we do not care about the corner cases
+                return false;
+
+            *pDst = (CL_BINOP_LSHIFT == code)
+                ? (a << b)
+                : (a >> b);
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+/// compute the value written by a non-terminal insn, false if not known
+bool evalInsn(TValue *pDst, const TState &state, const Insn &insn) {
+    const TOperandList &opList = insn.operands;
+    const enum cl_insn_e code = insn.code;
+    TValue a, b;
+    switch (code) {
+        case CL_INSN_UNOP:
+            return readOperand(&a, state, opList[/* src */ 1])
+                && evalUnop(pDst, static_cast<enum cl_unop_e>(insn.subCode), a);
+
+        case CL_INSN_BINOP:
+            return readOperand(&a, state, opList[/* src1 */ 1])
+                && readOperand(&b, state, opList[/* src2 */ 2])
+                && evalBinop(pDst, static_cast<enum cl_binop_e>(insn.subCode),
+                             a, b);
+
+        default:
+            // the value returned by a function is not known
+            return false;
+    }
+}
+
+/// update the state by a non-terminal insn
+void execInsn(TState &state, const Insn &insn) {
+    const enum cl_insn_e code = insn.code;
+    switch (code) {
+        case CL_INSN_UNOP:
+        case CL_INSN_BINOP:
+        case CL_INSN_CALL:
+            break;
+
+        default:
+            return;
+    }
+
+    const cl_operand &dst = insn.operands[/* dst */ 0];
+    if (!isTracked(*insn.stor, dst))
+        return;
+
+    const TVar uid = varIdFromOperand(&dst);
+    TValue val;
+    if (evalInsn(&val, state, insn) && fitsType(dst.type, val))
+        state[uid] = static_cast<int>(val);
+    else
+        state.erase(uid);
+}
+
+/// merge the state into the state of the given block, true if it has changed
+bool joinState(TStateMap &stateMap, const TBlock bb, const TState &state) {
+    const TStateMap::iterator it = stateMap.find(bb);
+    if (stateMap.end() == it) {
+        // reached for the first time
+        stateMap[bb] = state;
+        return true;
+    }
+
+    // keep only the values the both states agree on
+    TState &dst = it->second;
+    const unsigned cntOrig = dst.size();
+    for (TState::iterator vi = dst.begin(); vi != dst.end();) {
+        const TState::const_iterator si = state.find(vi->first);
+        if (state.end() == si || si->second != vi->second)
+            dst.erase(vi++);
+        else
+            ++vi;
+    }
+
+    return (dst.size() != cntOrig);
+}
+
+/// replace the conditional jump by a plain jump to the given target
+void foldCond(Insn *insn, const unsigned taken) {
+    CL_BREAK_IF(CL_INSN_COND != insn->code || 1U < taken);
+    CL_BREAK_IF(!insn->loopClosingTargets.empty());
+
+    TTargetList &tList = insn->targets;
+    const Block *target = tList[taken];
+    const_cast<Block *>(tList[!taken])->removePredecessor(insn->bb);
+
+    tList.clear();
+    tList.push_back(target);
+
+    // the variables are not killed yet, so there is nothing to preserve
+    insn->killPerTarget.clear();
+    insn->killPerTarget.resize(/* targets */ 1);
+
+    BOOST_FOREACH(struct cl_operand &op, insn->operands)
+        releaseOperand(op);
+
+    insn->operands.clear();
+    insn->code = CL_INSN_JMP;
+}
+
+void analyzeFnc(Fnc &fnc, unsigned *pCntFolded, unsigned *pCntRemoved) {
+    const TLoc loc = &fnc.def.data.cst.data.cst_fnc.loc;
+    CP_DEBUG_MSG(2, loc, ">>> entering " << nameOf(fnc) << "()");
+
+    // states at the entries of reachable blocks
+    TStateMap stateMap;
+
+    TDecisions decisions;
+
+    const TBlock entry = fnc.cfg.entry();
+    stateMap[entry] = TState();
+
+    std::stack<TBlock> todo;
+    TBlockSet queued;
+    todo.push(entry);
+    queued.insert(entry);
+
+    while (!todo.empty()) {
+        const TBlock bb = todo.top();
+        todo.pop();
+        queued.erase(bb);
+
+        TState state(stateMap[bb]);
+        BOOST_FOREACH(const TInsn insn, *bb)
+            execInsn(state, *insn);
+
+        const TInsn term = bb->back();
+        const TTargetList &tList = term->targets;
+        TTargetList reached(tList);
+
+        TValue val;
+        if (CL_INSN_COND == term->code
+                && readOperand(&val, state, term->operands[/* src */ 0]))
+        {
+            // the last visit of the block decides (the states only shrink)
+            const unsigned taken = (val) ? /* then */ 0 : /* else */ 1;
+            decisions[term] = taken;
+            reached.clear();
+            reached.push_back(tList[taken]);
+        }
+        else
+            decisions.erase(term);
+
+        BOOST_FOREACH(const TBlock target, reached)
+            if (joinState(stateMap, target, state)
+                    && insertOnce(queued, target))
+                todo.push(target);
+    }
+
+    BOOST_FOREACH(TDecisions::const_reference item, decisions) {
+        Insn *insn = const_cast<Insn *>(item.first);
+        CP_DEBUG_MSG(1, &insn->loc, "folding " << *insn
+                << " to target #" << item.second);
+
+        foldCond(insn, item.second);
+        ++(*pCntFolded);
+    }
+
+    // remove the blocks that cannot be reached any more
+    TBlockSet dead;
+    BOOST_FOREACH(const TBlock bb, fnc.cfg)
+        if (!hasKey(stateMap, bb))
+            dead.insert(bb);
+
+    if (dead.empty())
+        return;
+
+    BOOST_FOREACH(const TBlock bb, dead) {
+        CP_DEBUG_MSG(1, &bb->front()->loc, "removing unreachable block "
+                << bb->name());
+
+        BOOST_FOREACH(const TBlock target, bb->targets())
+            if (!hasKey(dead, target))
+                const_cast<Block *>(target)->removePredecessor(bb);
+    }
+
+    fnc.cfg.remove(dead);
+    BOOST_FOREACH(const TBlock bb, dead) {
+        destroyBlock(const_cast<Block *>(bb));
+        ++(*pCntRemoved);
+    }
+}
+
+} // namespace ConstProp
+
+void foldConstConditions(Storage &stor) {
+    StopWatch watch;
+    unsigned cntFolded = 0;
+    unsigned cntRemoved = 0;
+
+    // go through all _defined_ functions
+    BOOST_FOREACH(Fnc *pFnc, stor.fncs) {
+        Fnc &fnc = *pFnc;
+        if (!isDefined(fnc))
+            continue;
+
+        // analyze a single function
+        ConstProp::analyzeFnc(fnc, &cntFolded, &cntRemoved);
+    }
+
+    CL_DEBUG("foldConstConditions() folded " << cntFolded
+            << " condition(s), removed " << cntRemoved
+            << " unreachable block(s) and took " << watch);
+}
+
+} // namespace CodeStorage
@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2012 Kamil Dudka <kdudka@redhat.com>
+ *
+ * This file is part of predator.
+ *
+ * predator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * predator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with predator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef H_GUARD_CONSTPROP_H
+#define H_GUARD_CONSTPROP_H
+
+/**
+ * @file constprop.hh
+ * foldConstConditions - fold conditions with known outcome, drop dead code
+ */
+
+namespace CodeStorage {
+    struct Storage;
+
+    /**
+     * propagate integral constants through local variables whose address is
+     * never taken, replace conditional jumps with known outcome by plain jumps
+     * and remove basic blocks that become unreachable.  This needs to run
+     * before the call graph is built and before the variables are killed.
+     */
+    void foldConstConditions(Storage &stor);
+}
+
+#endif /* H_GUARD_CONSTPROP_H */
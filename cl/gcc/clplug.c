@@ -73,6 +73,9 @@
 // required by basename(3)
 #include <libgen.h>
 
+// required by close(2) and unlink(2)
+#include <unistd.h>
+
 #ifndef STREQ
 #   define STREQ(s1, s2) (0 == strcmp(s1, s2))
 #endif
@@ -149,6 +152,12 @@ static const char *plugin_name_alloc;
 // verbose bitmask
 static int verbose = 0;
 
+// analysis server the code model is sent to (if any)
+static const char *server_socket;
+static const char *server_args;
+static const char *server_model;
+static char server_model_tmp[] = "/tmp/cl-model-XXXXXX";
+
 // plug-in meta-data according to gcc plug-in API
 static struct plugin_info cl_info = {
     C99_FIELD(version) "%s [code listener SHA1 " CL_GIT_SHA1 "]",
@@ -161,11 +170,13 @@ static struct plugin_info cl_info = {
 "    -fplugin-arg-%s-version\n"
 "    -fplugin-arg-%s-args=PEER_ARGS                 args given to analyzer\n"
 "    -fplugin-arg-%s-dry-run                        do not run the analyzer\n"
+"    -fplugin-arg-%s-dump-model=FILE                dump code model to FILE\n"
 "    -fplugin-arg-%s-dump-pp[=OUTPUT_FILE]          dump linearized code\n"
 "    -fplugin-arg-%s-dump-types                     dump also type info\n"
 "    -fplugin-arg-%s-gen-dot[=GLOBAL_CG_FILE]       generate CFGs\n"
 "    -fplugin-arg-%s-pid-file=FILE                  write PID of self to FILE\n"
 "    -fplugin-arg-%s-preserve-ec                    do not affect exit code\n"
+"    -fplugin-arg-%s-server=SOCKET                  run analyzer in a server\n"
 "    -fplugin-arg-%s-type-dot=TYPE_GRAPH_FILE       generate type graphs\n"
 "    -fplugin-arg-%s-verbose[=VERBOSITY_LEVEL]      turn on verbose mode\n"
 };
@@ -204,7 +215,8 @@ static void init_plugin_name(const struct plugin_name_args *info)
     if (-1 == asprintf(&msg, cl_info.help, plugin_base_name,
                        name, name, name, name,
                        name, name, name, name,
-                       name, name, name, name))
+                       name, name, name, name,
+                       name, name))
         // OOM
         abort();
     else
@@ -1803,10 +1815,17 @@ static void cb_finish(void *gcc_data, void *user_data)
     if (error_detected())
         CL_WARN("some errors already detected, "
                 "additional passes will be skipped");
-    else
+    else {
         // this should trigger the code listener analyzer (if any)
         cl->acknowledge(cl);
 
+        // the model has been flushed by acknowledge, let the server analyze it
+        if (server_socket && cl_code_model_submit(server_socket, server_model,
+                                                  server_args))
+            // messages have been already printed out
+            ++cnt_errors;
+    }
+
     // FIXME: suboptimal interface of CL messaging
     if (!preserve_ec) {
         if (cnt_errors) {
@@ -1823,6 +1842,9 @@ static void cb_finish(void *gcc_data, void *user_data)
 
     // final cleanup
     cl->destroy(cl);
+    if (server_model == server_model_tmp)
+        unlink(server_model_tmp);
+
     cl_global_cleanup();
     var_db_destroy(var_db);
     type_db_destroy(type_db);
@@ -1878,11 +1900,13 @@ struct cl_plug_options {
     bool                    use_pp;
     bool                    use_analyzer;
     bool                    use_typedot;
+    const char              *dump_model_file;
     const char              *gl_dot_file;
     const char              *pp_out_file;
     const char              *analyzer_args;
     const char              *type_dot_file;
     const char              *pid_file;
+    const char              *server_socket;
 };
 
 static int clplug_init(const struct plugin_name_args *info,
@@ -1928,6 +1952,14 @@ static int clplug_init(const struct plugin_name_args *info,
             opt->use_analyzer   = false;
             // TODO: warn about ignoring extra value?
         }
+        else if (STREQ(key, "dump-model")) {
+            if (value)
+                opt->dump_model_file = value;
+            else {
+                CL_ERROR("mandatory value omitted for dump-model");
+                return EXIT_FAILURE;
+            }
+        }
         else if (STREQ(key, "dump-pp")) {
             opt->use_pp         = true;
             opt->pp_out_file    = value;
@@ -1954,6 +1986,14 @@ static int clplug_init(const struct plugin_name_args *info,
             }
 
         }
+        else if (STREQ(key, "server")) {
+            if (value)
+                opt->server_socket = value;
+            else {
+                CL_ERROR("mandatory value omitted for server");
+                return EXIT_FAILURE;
+            }
+        }
         else if (STREQ(key, "type-dot")) {
             if (value) {
                 opt->use_typedot    = true;
@@ -1970,6 +2010,26 @@ static int clplug_init(const struct plugin_name_args *info,
         }
     }
 
+    if (opt->server_socket && opt->use_analyzer) {
+        // the analyzer runs in the server, it is fed by the dumped code model
+        opt->use_analyzer   = false;
+        server_socket       = opt->server_socket;
+        server_args         = opt->analyzer_args;
+
+        if (!opt->dump_model_file) {
+            const int fd = mkstemp(server_model_tmp);
+            if (fd < 0) {
+                CL_ERROR("failed to create temporary file for code model");
+                return EXIT_FAILURE;
+            }
+
+            close(fd);
+            opt->dump_model_file = server_model_tmp;
+        }
+
+        server_model = opt->dump_model_file;
+    }
+
     return EXIT_SUCCESS;
 }
 
@@ -2023,6 +2083,13 @@ create_cl_chain(const struct cl_plug_options *opt)
         return NULL;
 #endif
 
+    // the code model is dumped as it is seen by the plug-in, no filters are
+    // applied here, so that any listener can be fed by the dumped model later
+    if (opt->dump_model_file && !cl_append_listener(chain,
+                "listener=\"dump\" listener_args=\"%s\"",
+                opt->dump_model_file))
+        return NULL;
+
     if (opt->use_pp) {
         const char *use_listener = (opt->dump_types)
             ? "pp_with_types"
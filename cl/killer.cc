@@ -29,8 +29,11 @@
 #include "stopwatch.hh"
 #include "util.hh"
 
+#include <algorithm>
 #include <map>
 #include <set>
+#include <utility>
+#include <vector>
 
 #include <boost/foreach.hpp>
 
@@ -55,22 +58,111 @@ typedef const struct cl_loc                *TLoc;
 typedef int                                 TVar;
 typedef std::set<TVar>                      TSet;
 typedef const Block                        *TBlock;
-typedef std::set<TBlock>                    TBlockSet;
-typedef std::vector<TSet>                   TLivePerTarget;
 
-/// per-block data
-struct BlockData {
+/// dense index of a variable, the order of indexes follows the order of uids
+typedef unsigned                            TIdx;
+typedef std::vector<TIdx>                   TIdxList;
+
+/// packed bit vector indexed by the dense index of variables
+class BitSet {
+    public:
+        BitSet(unsigned size = 0):
+            words_((size + BITS - 1) / BITS, 0UL)
+        {
+        }
+
+        bool test(const TIdx idx) const {
+            return !!(words_[idx / BITS] & maskOf(idx));
+        }
+
+        /// return true if the bit has not been set before
+        bool set(const TIdx idx) {
+            TWord &word = words_[idx / BITS];
+            const TWord mask = maskOf(idx);
+            if (word & mask)
+                return false;
+
+            word |= mask;
+            return true;
+        }
+
+        void reset(const TIdx idx) {
+            words_[idx / BITS] &= ~maskOf(idx);
+        }
+
+        /// (*this) |= src
+        void unite(const BitSet &src) {
+            for (unsigned i = 0; i < words_.size(); ++i)
+                words_[i] |= src.words_[i];
+        }
+
+        /// (*this) |= (src & ~mask), return true if anything has changed
+        bool uniteExcept(const BitSet &src, const BitSet &mask) {
+            bool anyChange = false;
+            for (unsigned i = 0; i < words_.size(); ++i) {
+                const TWord word =
+                    words_[i] | (src.words_[i] & ~mask.words_[i]);
+
+                if (word == words_[i])
+                    continue;
+
+                words_[i] = word;
+                anyChange = true;
+            }
+
+            return anyChange;
+        }
+
+        /// append indexes of all the bits set to dst, in ascending order
+        void toList(TIdxList &dst) const {
+            for (unsigned i = 0; i < words_.size(); ++i)
+                for (TWord word = words_[i]; word; word &= word - 1UL)
+                    dst.push_back(i * BITS + __builtin_ctzl(word));
+        }
+
+    private:
+        typedef unsigned long TWord;
+        enum { BITS = /* bits per word */ 8 * sizeof(TWord) };
+
+        static TWord maskOf(const TIdx idx) {
+            return 1UL << (idx % BITS);
+        }
+
+        std::vector<TWord>                  words_;
+};
+
+typedef std::vector<BitSet>                 TLivePerTarget;
+
+/// variables read and written by a single instruction, as found by scanInsn()
+struct InsnData {
     TSet                                    gen;
     TSet                                    kill;
 };
 
-typedef std::map<TBlock, BlockData>         TMap;
+/// InsnData translated to dense indexes, both lists are sorted
+struct InsnSummary {
+    TIdxList                                gen;
+    TIdxList                                touched;
+};
+
+/// per-block data
+struct BlockData {
+    TBlock                                  bb;
+    std::vector<InsnSummary>                insns;
+    std::vector<unsigned>                   succs;
+    BitSet                                  gen;
+    BitSet                                  kill;
+};
 
 /// shared data
 struct Data {
     TStorRef                                stor;
-    TBlockSet                               todo;
-    TMap                                    blocks;
+    std::map<TVar, TIdx>                    idxByVar;
+    std::vector<TVar>                       varByIdx;
+    std::map<TBlock, unsigned>              idxByBlock;
+
+    /// in postorder, which suits the backward direction of the dataflow
+    std::vector<BlockData>                  blocks;
 
     Data(TStorRef stor_):
         stor(stor_)
@@ -78,7 +170,7 @@ struct Data {
     }
 };
 
-void scanOperand(BlockData &bData, const cl_operand &op, bool dst) {
+void scanOperand(InsnData &iData, const cl_operand &op, bool dst) {
     VK_DEBUG(4, "scanOperand: " << op << ((dst) ? " [dst]" : " [src]"));
 
     bool fieldOfComp = false;
@@ -90,7 +182,7 @@ void scanOperand(BlockData &bData, const cl_operand &op, bool dst) {
         switch (code) {
             case CL_ACCESSOR_DEREF_ARRAY:
                 // FIXME: unguarded recursion
-                scanOperand(bData, *(ac->data.array.index), /* dst */ false);
+                scanOperand(iData, *(ac->data.array.index), /* dst */ false);
                 // fall through!
 
             case CL_ACCESSOR_DEREF:
@@ -119,24 +211,24 @@ void scanOperand(BlockData &bData, const cl_operand &op, bool dst) {
 
     const char *name = NULL;
     const int uid = varIdFromOperand(&op, &name);
-    if (hasKey(bData.kill, uid))
+    if (hasKey(iData.kill, uid))
         // already killed
         return;
 
     if (dst) {
         VK_DEBUG(3, "kill(" << name << ")");
-        bData.kill.insert(uid);
+        iData.kill.insert(uid);
         return;
     }
 
     // we see the operand as [src]
-    if (insertOnce(bData.gen, uid))
+    if (insertOnce(iData.gen, uid))
         VK_DEBUG(3, "gen(" << name << ")");
 }
 
-void scanInsn(BlockData &bData, const Insn &insn) {
+void scanInsn(InsnData &iData, const Insn &insn) {
     VK_DEBUG_MSG(3, &insn.loc, "scanInsn: " << insn);
-    const TOperandList opList = insn.operands;
+    const TOperandList &opList = insn.operands;
 
     const enum cl_insn_e code = insn.code;
     switch (code) {
@@ -151,14 +243,14 @@ void scanInsn(BlockData &bData, const Insn &insn) {
             // go backwards!
             CL_BREAK_IF(opList.empty());
             for (int i = opList.size() - 1; 0 <= i; --i)
-                scanOperand(bData, opList[i], /* dst */ !i);
+                scanOperand(iData, opList[i], /* dst */ !i);
             return;
 
         case CL_INSN_RET:
         case CL_INSN_COND:
         case CL_INSN_SWITCH:
             // exactly one operand
-            scanOperand(bData, opList[/* src */ 0], /* dst */ false);
+            scanOperand(iData, opList[/* src */ 0], /* dst */ false);
             return;
 
         case CL_INSN_JMP:
@@ -170,47 +262,123 @@ void scanInsn(BlockData &bData, const Insn &insn) {
     }
 }
 
-void updateBlock(Data &data, TBlock bb) {
-    VK_DEBUG_MSG(2, &bb->front()->loc, "updateBlock: " << bb->name());
-    BlockData &bData = data.blocks[bb];
-    bool anyChange = false;
+void translateVars(TIdxList &dst, const Data &data, const TSet &vars) {
+    BOOST_FOREACH(const TVar uid, vars) {
+        const std::map<TVar, TIdx>::const_iterator it = data.idxByVar.find(uid);
+        CL_BREAK_IF(data.idxByVar.end() == it);
+        dst.push_back(it->second);
+    }
+}
 
-    // go through all variables generated by successors
-    BOOST_FOREACH(TBlock bbSrc, bb->targets()) {
-        BlockData &bDataSrc = data.blocks[bbSrc];
+/// order the blocks in postorder, the blocks unreachable from entry go last
+void sortBlocks(Data &data, const ControlFlow &cfg) {
+    typedef std::pair<TBlock, unsigned /* next target */> TItem;
+    std::set<TBlock> seen;
+
+    BOOST_FOREACH(const TBlock root, cfg) {
+        if (!insertOnce(seen, root))
+            continue;
+
+        std::vector<TItem> stack;
+        stack.push_back(TItem(root, 0U));
+        while (!stack.empty()) {
+            TItem &item = stack.back();
+            const TTargetList &targets = item.first->targets();
+            if (item.second < targets.size()) {
+                const TBlock next = targets[item.second++];
+                if (insertOnce(seen, next))
+                    stack.push_back(TItem(next, 0U));
 
-        // update self
-        BOOST_FOREACH(TVar uid, bDataSrc.gen) {
-            if (hasKey(bData.kill, uid))
-                // we are killing the variable
                 continue;
+            }
 
-            if (insertOnce(bData.gen, uid))
-                anyChange = true;
+            BlockData bData;
+            bData.bb = item.first;
+            data.blocks.push_back(bData);
+            stack.pop_back();
         }
     }
 
-    if (!anyChange)
-        // nothing updated actually
-        return;
+    for (unsigned i = 0; i < data.blocks.size(); ++i)
+        data.idxByBlock[data.blocks[i].bb] = i;
+}
+
+void scanFnc(Data &data, const Fnc &fnc) {
+    sortBlocks(data, fnc.cfg);
+
+    // scan all instructions once, remember what they read and write
+    TSet vars;
+    typedef std::vector<InsnData> TInsnDataList;
+    std::vector<TInsnDataList> scans(data.blocks.size());
+    for (unsigned i = 0; i < data.blocks.size(); ++i) {
+        const TBlock bb = data.blocks[i].bb;
+        VK_DEBUG(3, "in block " << bb->name());
 
-    // schedule all predecessors
-    BOOST_FOREACH(TBlock bbDst, bb->inbound())
-        data.todo.insert(bbDst);
+        TInsnDataList &iDataList = scans[i];
+        iDataList.resize(bb->size());
+        for (unsigned j = 0; j < bb->size(); ++j) {
+            InsnData &iData = iDataList[j];
+            scanInsn(iData, *bb->operator[](j));
+            vars.insert(iData.gen.begin(), iData.gen.end());
+            vars.insert(iData.kill.begin(), iData.kill.end());
+        }
+    }
+
+    // number the variables densely
+    BOOST_FOREACH(const TVar uid, vars) {
+        data.idxByVar[uid] = data.varByIdx.size();
+        data.varByIdx.push_back(uid);
+    }
+
+    const unsigned cntVars = vars.size();
+    for (unsigned i = 0; i < data.blocks.size(); ++i) {
+        BlockData &bData = data.blocks[i];
+        bData.gen = BitSet(cntVars);
+        bData.kill = BitSet(cntVars);
+
+        BOOST_FOREACH(const TBlock target, bData.bb->targets())
+            bData.succs.push_back(data.idxByBlock[target]);
+
+        const TInsnDataList &iDataList = scans[i];
+        bData.insns.resize(iDataList.size());
+        for (unsigned j = 0; j < iDataList.size(); ++j) {
+            const InsnData &iData = iDataList[j];
+            InsnSummary &summary = bData.insns[j];
+
+            TIdxList kill;
+            translateVars(summary.gen, data, iData.gen);
+            translateVars(kill, data, iData.kill);
+
+            // variables read by the insn are generated unless killed before
+            BOOST_FOREACH(const TIdx var, summary.gen)
+                if (!bData.kill.test(var))
+                    bData.gen.set(var);
+
+            BOOST_FOREACH(const TIdx var, kill)
+                bData.kill.set(var);
+
+            // handle killed variables same way as generated (make an union)
+            TSet touched(iData.kill);
+            touched.insert(iData.gen.begin(), iData.gen.end());
+            translateVars(summary.touched, data, touched);
+        }
+    }
 }
 
 void computeFixPoint(Data &data) {
-    // fixed-point computation
+    // fixed-point computation, the gen set of a block grows by the variables
+    // generated by its successors and not killed by the block itself
     unsigned cntSteps = 1;
-    TBlockSet &todo = data.todo;
-    while (!todo.empty()) {
-        TBlockSet::iterator i = todo.begin();
-        TBlock bb = *i;
-        todo.erase(i);
-
-        // (re)compute a single basic block
-        updateBlock(data, bb);
-        ++cntSteps;
+    bool anyChange = true;
+    while (anyChange) {
+        anyChange = false;
+        BOOST_FOREACH(BlockData &bData, data.blocks) {
+            BOOST_FOREACH(const unsigned succ, bData.succs)
+                if (bData.gen.uniteExcept(data.blocks[succ].gen, bData.kill))
+                    anyChange = true;
+
+            ++cntSteps;
+        }
     }
 
     VK_DEBUG(2, "fixed-point reached in " << cntSteps << " steps");
@@ -239,7 +407,8 @@ void killVariablePerTarget(
 void commitInsn(
         Data                    &data,
         Insn                    &insn,
-        TSet                    &live,
+        const InsnSummary       &summary,
+        BitSet                  &live,
         TLivePerTarget          &livePerTarget)
 {
     const TStorRef stor = data.stor;
@@ -249,22 +418,14 @@ void commitInsn(
     const unsigned cntTargets = targets.size();
     const bool multipleTargets = (1 < cntTargets);
 
-    // FIXME: performance waste
-    // info about which variables are generated and killed by this particular
-    // instruction 'insn' could be precomputed already (in analyzeFnc() - before
-    // computeFixPoint() call).
-    BlockData arena;
-    scanInsn(arena, insn);
-
-    // handle killed variables same way as generated (make an union)
-    TSet touched = arena.kill;
-    touched.insert(arena.gen.begin(), arena.gen.end());
+    const TIdxList &gen = summary.gen;
 
     // go through variables generated by the current instruction
-    BOOST_FOREACH(TVar vKill, touched) {
+    BOOST_FOREACH(const TIdx var, summary.touched) {
+        const TVar vKill = data.varByIdx[var];
         const bool isPointed = stor.vars[vKill].mayBePointed;
 
-        if (insertOnce(live, vKill)) {
+        if (live.set(var)) {
             // variable was marked as dead in following instruction -- may be
             // killed after execution of this instruction
             VK_DEBUG_MSG(1, &insn.loc, "killing variable "
@@ -279,14 +440,14 @@ void commitInsn(
                 // to prevent following code to re-kill it again for particular
                 // target
                 for (unsigned i = 0; i < cntTargets; ++i)
-                    livePerTarget[i].insert(vKill);
+                    livePerTarget[i].set(var);
             }
         }
 
-        if (!hasKey(arena.gen, vKill)) {
+        if (!std::binary_search(gen.begin(), gen.end(), var)) {
             // this variable is killed by this instruction && is _not_ generated
             // here - it must be switched to dead status
-            live.erase(vKill);
+            live.reset(var);
             // NOTE: It is not possible to re-kill the 'vKill' for particular
             // targets *only* because:
             //   a) future turns: 'vKill' is is not generated => is dead for
@@ -304,7 +465,7 @@ void commitInsn(
         // means that it is "live" at least in one of the block targets) try to
         // kill it for those particular targets
         for (unsigned i = 0; i < cntTargets; ++i) {
-            if (!insertOnce(livePerTarget[i], vKill))
+            if (!livePerTarget[i].set(var))
                 continue;
 
             killVariablePerTarget(stor, bb, i, vKill);
@@ -312,25 +473,25 @@ void commitInsn(
     }
 }
 
-void commitBlock(Data &data, TBlock bb) {
+void commitBlock(Data &data, const BlockData &bData) {
+    const TBlock bb = bData.bb;
     const TTargetList &targets = bb->targets();
     const unsigned cntTargets = targets.size();
     const bool multipleTargets = (1 < cntTargets);
     TStorRef stor = data.stor;
+    const unsigned cntVars = data.varByIdx.size();
 
     TLivePerTarget livePerTarget;
     if (multipleTargets)
-        livePerTarget.resize(cntTargets);
+        livePerTarget.resize(cntTargets, BitSet(cntVars));
 
     // build list of live variables coming from all successors
-    TSet live;
+    BitSet live(cntVars);
     for (unsigned i = 0; i < cntTargets; ++i) {
-        const TBlock bbSrc = targets[i];
-        BOOST_FOREACH(TVar vLive, data.blocks[bbSrc].gen) {
-            live.insert(vLive);
-            if (multipleTargets)
-                livePerTarget[i].insert(vLive);
-        }
+        const BitSet &genSrc = data.blocks[bData.succs[i]].gen;
+        live.unite(genSrc);
+        if (multipleTargets)
+            livePerTarget[i].unite(genSrc);
     }
 
     // go backwards through the instructions
@@ -338,7 +499,7 @@ void commitBlock(Data &data, TBlock bb) {
     for (int i = bb->size()-1; 0 <= i; --i) {
         const Insn *pInsn = bb->operator[](i);
         Insn &insn = *const_cast<Insn *>(pInsn);
-        commitInsn(data, insn, live, livePerTarget);
+        commitInsn(data, insn, bData.insns[i], live, livePerTarget);
     }
 
     if (!multipleTargets)
@@ -347,36 +508,25 @@ void commitBlock(Data &data, TBlock bb) {
     // finish this block -- there may stay some variables that are untouched by
     // this block and/but these are alive only for some of targets --> lets
     // catch these these fugitives.
+    TIdxList liveList;
+    live.toList(liveList);
 
-    TSet::const_iterator liveIt, perTargetIt;
     for (unsigned target = 0; target < cntTargets; ++target) {
-        TLivePerTarget::const_reference perTarget = livePerTarget[target];
-
-        liveIt = live.begin();
-        perTargetIt = perTarget.begin();
-
-        // complexity O(N) (N is number of variables in live).  Note that this
-        // needs the 'live' and 'livePerTarget' lists to be sorted
-        while (liveIt != live.end() && perTarget.end() != perTargetIt) {
-
-            int uidLive = *liveIt;
-            int uidPerTarget = *perTargetIt;
-
-            if (uidPerTarget < uidLive) {
-                // uidPerTarget is killed for particular target
-                ++perTargetIt;
-                continue;
-            }
+        TIdxList perTarget;
+        livePerTarget[target].toList(perTarget);
+        if (perTarget.empty())
+            continue;
 
-            else if (uidLive == uidPerTarget) {
-                ++perTargetIt;
-                ++liveIt;
-                continue;
-            }
+        // only the variables below the greatest one live for this target are
+        // considered, exactly as the former merge of the sorted lists did
+        const TIdx last = perTarget.back();
+        BOOST_FOREACH(const TIdx var, liveList) {
+            if (last < var)
+                break;
 
-            // OK, now we have untouched variable 'uidLive'
-            killVariablePerTarget(stor, bb, target, uidLive);
-            ++liveIt;
+            if (!livePerTarget[target].test(var))
+                // OK, now we have untouched variable 'var'
+                killVariablePerTarget(stor, bb, target, data.varByIdx[var]);
         }
     }
 }
@@ -387,20 +537,9 @@ void analyzeFnc(Fnc &fnc) {
 
     TLoc loc = &fnc.def.data.cst.data.cst_fnc.loc;
     VK_DEBUG_MSG(2, loc, ">>> entering " << nameOf(fnc) << "()");
-    CL_BREAK_IF(!data.todo.empty());
 
-    // go through basic blocks
-    BOOST_FOREACH(const TBlock bb, fnc.cfg) {
-        // go through instructions in forward direction
-        VK_DEBUG(3, "in block " << bb->name());
-
-        BOOST_FOREACH(const Insn *insn, *bb) {
-            BlockData &bData = data.blocks[bb];
-            scanInsn(bData, *insn);
-        }
-
-        data.todo.insert(bb);
-    }
+    // go through basic blocks and number the variables
+    scanFnc(data, fnc);
 
     // compute a fixed-point for a single function
     VK_DEBUG_MSG(2, loc, "computing fixed-point for " << nameOf(fnc) << "()");
@@ -409,7 +548,7 @@ void analyzeFnc(Fnc &fnc) {
     // commit the results
     BOOST_FOREACH(const TBlock bb, fnc.cfg) {
         VK_DEBUG_MSG(2, &bb->front()->loc, "commitBlock: " << bb->name());
-        commitBlock(data, bb);
+        commitBlock(data, data.blocks[data.idxByBlock[bb]]);
     }
 }
 
@@ -26,8 +26,10 @@
 #include "util.hh"
 #include "stopwatch.hh"
 
+#include <map>
 #include <set>
 #include <stack>
+#include <vector>
 
 #include <boost/foreach.hpp>
 
@@ -140,6 +142,172 @@ void analyzeFnc(Fnc &fnc) {
     }
 }
 
+typedef std::vector<unsigned>               TNumList;
+
+/// disjoint sets of DFS numbers, the representative is the outermost one
+class UnionFind {
+    public:
+        UnionFind(unsigned cnt):
+            parent_(cnt)
+        {
+            for (unsigned num = 0; num < cnt; ++num)
+                parent_[num] = num;
+        }
+
+        unsigned find(unsigned num) {
+            while (parent_[num] != num) {
+                // path halving
+                parent_[num] = parent_[parent_[num]];
+                num = parent_[num];
+            }
+
+            return num;
+        }
+
+        void unite(unsigned num, unsigned into) {
+            parent_[num] = into;
+        }
+
+    private:
+        TNumList                    parent_;
+};
+
+/// Havlak's algorithm with the Ramalingam's fix for irreducible loops
+void buildLoopForest(Fnc &fnc) {
+    ControlFlow &cfg = fnc.cfg;
+    const TBlock entry = cfg.entry();
+
+    // number the blocks in DFS pre-order, collect them in post-order as well
+    std::map<TBlock, unsigned> numByBlock;
+    TTargetList byNum, postOrder;
+    TNumList last;
+
+    numByBlock[entry] = 0U;
+    byNum.push_back(entry);
+    last.push_back(0U);
+
+    TDfsStack dfsStack;
+    dfsStack.push(DfsItem(entry));
+    while (!dfsStack.empty()) {
+        DfsItem &top = dfsStack.top();
+        const TTargetList &tlist = top.bb->targets();
+        if (top.target < tlist.size()) {
+            const TBlock bbNext = tlist[top.target++];
+            if (hasKey(numByBlock, bbNext))
+                continue;
+
+            numByBlock[bbNext] = byNum.size();
+            byNum.push_back(bbNext);
+            last.push_back(0U);
+            dfsStack.push(DfsItem(bbNext));
+            continue;
+        }
+
+        // the last descendant of the block has been numbered by now
+        last[numByBlock[top.bb]] = byNum.size() - 1U;
+        postOrder.push_back(top.bb);
+        dfsStack.pop();
+    }
+
+    const unsigned cnt = byNum.size();
+
+    // classify the edges entering each block by means of the DFS tree
+    std::vector<TNumList> backPreds(cnt), nonBackPreds(cnt);
+    for (unsigned w = 0; w < cnt; ++w) {
+        BOOST_FOREACH(const TBlock pred, byNum[w]->inbound()) {
+            std::map<TBlock, unsigned>::const_iterator it =
+                numByBlock.find(pred);
+            if (numByBlock.end() == it)
+                // edge from an unreachable block
+                continue;
+
+            const unsigned v = it->second;
+            if (w <= v && v <= last[w])
+                backPreds[w].push_back(v);
+            else
+                nonBackPreds[w].push_back(v);
+        }
+    }
+
+    // go through the potential headers from the innermost ones
+    std::vector<int> headerOf(cnt, /* not in any loop */ -1);
+    std::vector<LoopInfo> infos(cnt);
+    UnionFind loops(cnt);
+    for (int w = cnt - 1; 0 <= w; --w) {
+        std::set<unsigned> body;
+        std::stack<unsigned> todo;
+        BOOST_FOREACH(const unsigned v, backPreds[w]) {
+            if (static_cast<unsigned>(w) == v) {
+                // self-loop
+                infos[w].isHeader = true;
+                continue;
+            }
+
+            const unsigned x = loops.find(v);
+            if (insertOnce(body, x))
+                todo.push(x);
+        }
+
+        // collect the loop body by walking backwards from the loop-closing edges
+        while (!todo.empty()) {
+            const unsigned x = todo.top();
+            todo.pop();
+
+            BOOST_FOREACH(const unsigned y, nonBackPreds[x]) {
+                const unsigned yy = loops.find(y);
+                if (yy < static_cast<unsigned>(w) || last[w] < yy) {
+                    // the loop can be entered other way than through w
+                    infos[w].isIrreducible = true;
+                    nonBackPreds[w].push_back(yy);
+                    continue;
+                }
+
+                if (static_cast<unsigned>(w) != yy && insertOnce(body, yy))
+                    todo.push(yy);
+            }
+        }
+
+        if (!body.empty())
+            infos[w].isHeader = true;
+
+        BOOST_FOREACH(const unsigned x, body) {
+            headerOf[x] = w;
+            loops.unite(x, w);
+        }
+    }
+
+    // headers precede the blocks of their loops in the DFS pre-order
+    for (unsigned w = 0; w < cnt; ++w) {
+        LoopInfo &li = infos[w];
+        const int h = headerOf[w];
+        if (0 <= h) {
+            li.parent = byNum[h];
+            li.depth = infos[h].depth;
+        }
+
+        if (li.isHeader) {
+            ++li.depth;
+            LS_DEBUG(2, "loop header " << byNum[w]->name()
+                    << " (depth " << li.depth
+                    << ((li.isIrreducible) ? ", irreducible" : "") << ")");
+        }
+    }
+
+    TTargetList rpo(postOrder.rbegin(), postOrder.rend());
+    for (unsigned idx = 0; idx < cnt; ++idx)
+        infos[numByBlock[rpo[idx]]].rpoIdx = idx;
+
+    // blocks not reachable from the entry get the default LoopInfo
+    BOOST_FOREACH(Block *bb, cfg) {
+        std::map<TBlock, unsigned>::const_iterator it = numByBlock.find(bb);
+        bb->setLoopInfo((numByBlock.end() == it)
+                ? LoopInfo()
+                : infos[it->second]);
+    }
+
+    cfg.setRpo(rpo);
+}
+
 } // namespace LoopScan
 
 void findLoopClosingEdges(Storage &stor) {
@@ -153,6 +321,7 @@ void findLoopClosingEdges(Storage &stor) {
 
         // analyze a single function
         LoopScan::analyzeFnc(fnc);
+        LoopScan::buildLoopForest(fnc);
     }
 
     // print time elapsed
@@ -22,12 +22,18 @@
 
 /**
  * @file loopscan.hh
- * @todo some dox
+ * findLoopClosingEdges - loops at the level of control flow graphs
  */
 
 namespace CodeStorage {
     struct Storage;
 
+    /**
+     * mark the loop-closing edges (see Insn::loopClosingTargets) in all the
+     * defined functions, then build the loop-nesting forest of each CFG (see
+     * Block::loopInfo()) and number its blocks in reverse post-order (see
+     * ControlFlow::rpo()), irreducible loops included
+     */
     void findLoopClosingEdges(Storage &stor);
 }
 
@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2012 Kamil Dudka <kdudka@redhat.com>
+ *
+ * This file is part of predator.
+ *
+ * predator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * predator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with predator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config_cl.h"
+#include "slicer.hh"
+
+#include <cl/cl_msg.hh>
+#include <cl/cldebug.hh>
+#include <cl/clutil.hh>
+#include <cl/storage.hh>
+
+#include "cl_storage.hh"
+#include "stopwatch.hh"
+#include "util.hh"
+#include "worklist.hh"
+
+#include <map>
+#include <set>
+
+#include <boost/foreach.hpp>
+
+static int debugSlicer = CL_DEBUG_SLICER;
+
+#define SC_DEBUG(level, ...) do {                                           \
+    if ((level) <= ::debugSlicer)                                           \
+        CL_DEBUG("Slicer: " << __VA_ARGS__);                                \
+} while (0)
+
+#define SC_DEBUG_MSG(level, lw, ...) do {                                   \
+    if ((level) <= ::debugSlicer)                                           \
+        CL_DEBUG_MSG(lw, "Slicer: " << __VA_ARGS__);                        \
+} while (0)
+
+namespace CodeStorage {
+
+namespace Slicer {
+
+typedef const struct cl_loc                *TLoc;
+typedef const Insn                         *TInsn;
+typedef int                                 TVar;
+typedef std::map<TVar, TInsnList>           TDefs;
+typedef std::set<TInsn>                     TInsnSet;
+typedef std::map<Block *, TInsnSet>         TInsnsByBlock;
+
+/// gather all variables the operand reads from, including array indexes
+void readVars(TVarSet &dst, const cl_operand &op) {
+    for (const cl_accessor *ac = op.accessor; ac; ac = ac->next)
+        if (CL_ACCESSOR_DEREF_ARRAY == ac->code)
+            readVars(dst, *ac->data.array.index);
+
+    if (CL_OPERAND_VAR == op.code)
+        dst.insert(varIdFromOperand(&op));
+}
+
+/// true if the operand accesses memory through a pointer or an array index
+bool hasDeref(const cl_operand &op) {
+    for (const cl_accessor *ac = op.accessor; ac; ac = ac->next) {
+        const enum cl_accessor_e code = ac->code;
+        if (CL_ACCESSOR_DEREF == code || CL_ACCESSOR_DEREF_ARRAY == code)
+            return true;
+    }
+
+    return false;
+}
+
+bool isNonPointerScalar(const struct cl_type *clt) {
+    const enum cl_type_e code = clt->code;
+    switch (code) {
+        case CL_TYPE_INT:
+        case CL_TYPE_CHAR:
+        case CL_TYPE_BOOL:
+        case CL_TYPE_ENUM:
+        case CL_TYPE_REAL:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+/// true if the insn only computes a value of a local non-pointer variable
+bool isRemovable(const Storage &stor, const Insn &insn) {
+    const enum cl_insn_e code = insn.code;
+    if (CL_INSN_UNOP != code && CL_INSN_BINOP != code)
+        return false;
+
+    const TOperandList &opList = insn.operands;
+    const cl_operand &dst = opList[/* dst */ 0];
+    if (dst.accessor || !isLcVar(dst) || !isNonPointerScalar(dst.type))
+        return false;
+
+    const TVar uid = varIdFromOperand(&dst);
+    if (stor.vars[uid].mayBePointed)
+        // the value may be read through a pointer
+        return false;
+
+    for (unsigned i = /* src */ 1; i < opList.size(); ++i)
+        if (hasDeref(opList[i]))
+            // invalid dereference would go unnoticed
+            return false;
+
+    return true;
+}
+
+unsigned analyzeFnc(Fnc &fnc) {
+    const Storage &stor = *fnc.stor;
+    const TLoc loc = &fnc.def.data.cst.data.cst_fnc.loc;
+    SC_DEBUG_MSG(2, loc, ">>> entering " << nameOf(fnc) << "()");
+
+    // variables read by the instructions we need to keep
+    TVarSet relevant;
+
+    // removable instructions by the variable they write to
+    TDefs defs;
+
+    BOOST_FOREACH(const Block *bb, fnc.cfg) {
+        BOOST_FOREACH(const TInsn insn, *bb) {
+            if (isRemovable(stor, *insn)) {
+                const TVar uid = varIdFromOperand(&insn->operands[/* dst */ 0]);
+                defs[uid].push_back(insn);
+                continue;
+            }
+
+            BOOST_FOREACH(const cl_operand &op, insn->operands)
+                readVars(relevant, op);
+        }
+    }
+
+    // a variable is relevant if any relevant variable is computed from it
+    WorkList<TVar> wl;
+    BOOST_FOREACH(const TVar uid, relevant)
+        wl.schedule(uid);
+
+    TVar uid;
+    while (wl.next(uid)) {
+        const TDefs::const_iterator it = defs.find(uid);
+        if (defs.end() == it)
+            continue;
+
+        BOOST_FOREACH(const TInsn insn, /* TInsnList */ it->second) {
+            TVarSet srcs;
+            const TOperandList &opList = insn->operands;
+            for (unsigned i = /* src */ 1; i < opList.size(); ++i)
+                readVars(srcs, opList[i]);
+
+            BOOST_FOREACH(const TVar src, srcs)
+                wl.schedule(src);
+        }
+    }
+
+    // remove the instructions computing irrelevant variables
+    TInsnsByBlock doomed;
+    BOOST_FOREACH(TDefs::const_reference item, defs) {
+        if (wl.seen(/* uid */ item.first))
+            continue;
+
+        BOOST_FOREACH(const TInsn insn, /* TInsnList */ item.second) {
+            SC_DEBUG_MSG(1, &insn->loc, "removing " << *insn);
+            doomed[insn->bb].insert(insn);
+        }
+    }
+
+    unsigned cnt = 0;
+    BOOST_FOREACH(TInsnsByBlock::const_reference item, doomed) {
+        item.first->remove(item.second);
+        BOOST_FOREACH(const TInsn insn, item.second) {
+            destroyInsn(const_cast<Insn *>(insn));
+            ++cnt;
+        }
+    }
+
+    return cnt;
+}
+
+} // namespace Slicer
+
+void sliceIrrelevantInsns(Storage &stor) {
+    StopWatch watch;
+    unsigned cnt = 0;
+
+    // go through all _defined_ functions
+    BOOST_FOREACH(Fnc *pFnc, stor.fncs) {
+        Fnc &fnc = *pFnc;
+        if (!isDefined(fnc))
+            continue;
+
+        // analyze a single function
+        cnt += Slicer::analyzeFnc(fnc);
+    }
+
+    CL_DEBUG("sliceIrrelevantInsns() removed " << cnt
+            << " instruction(s) and took " << watch);
+}
+
+} // namespace CodeStorage
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2012 Kamil Dudka <kdudka@redhat.com>
+ *
+ * This file is part of predator.
+ *
+ * predator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * predator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with predator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_GUARD_SLICER_H
+#define H_GUARD_SLICER_H
+
+/**
+ * @file slicer.hh
+ * sliceIrrelevantInsns - remove instructions that cannot influence the heap
+ */
+
+namespace CodeStorage {
+    struct Storage;
+
+    /**
+     * remove instructions that only compute values of local non-pointer
+     * variables, which never (even transitively) flow into a pointer, a memory
+     * access, a condition, a call, or a return value.  This needs to run
+     * before the call graph is built and before the variables are killed.
+     * Any folding of conditions needs to be done already, so that the slicer
+     * sees the final shape of the code.
+     */
+    void sliceIrrelevantInsns(Storage &stor);
+}
+
+#endif /* H_GUARD_SLICER_H */
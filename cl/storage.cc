@@ -25,8 +25,11 @@
 #include "cl_storage.hh"
 #include "util.hh"
 
+#include <algorithm>
 #include <map>
 #include <stack>
+#include <unordered_map>
+#include <vector>
 
 #include <boost/foreach.hpp>
 #include <boost/tuple/tuple.hpp>
@@ -34,6 +37,89 @@
 namespace CodeStorage {
 
 namespace {
+    /**
+     * mapping from uid to index, meant for uids assigned by the front-end
+     *
+     * Uids that are small enough compared to the count of items indexed so far
+     * are looked up by direct indexing of a vector.  The rest of them (GCC
+     * tends to use sparse uids for declarations) go to a hash table.
+     */
+    class UidIndex {
+        public:
+            UidIndex():
+                cnt_(0)
+            {
+            }
+
+            bool find(int uid, unsigned *pIdx) const {
+                if (0 <= uid && static_cast<unsigned>(uid) < dense_.size()) {
+                    // zero means no item, see insert()
+                    const unsigned slot = dense_[uid];
+                    if (slot) {
+                        *pIdx = slot - 1;
+                        return true;
+                    }
+                }
+
+                if (sparse_.empty())
+                    return false;
+
+                const TSparse::const_iterator iter = sparse_.find(uid);
+                if (sparse_.end() == iter)
+                    return false;
+
+                *pIdx = iter->second;
+                return true;
+            }
+
+            void insert(int uid, unsigned idx) {
+                ++cnt_;
+
+                // let the dense table take up to 4 slots per item indexed
+                const unsigned limit = DENSE_MIN + (cnt_ << 2);
+                if (uid < 0 || limit <= static_cast<unsigned>(uid)) {
+                    sparse_[uid] = idx;
+                    return;
+                }
+
+                if (dense_.size() <= static_cast<unsigned>(uid))
+                    dense_.resize(uid + 1, 0U);
+
+                dense_[uid] = idx + 1;
+            }
+
+        private:
+            typedef std::unordered_map<int, unsigned>   TSparse;
+            enum { DENSE_MIN = 0x400 };
+
+            std::vector<unsigned>   dense_;
+            TSparse                 sparse_;
+            unsigned                cnt_;
+    };
+
+    template <class TDb, class TKey>
+    bool dbFind(const TDb &db, TKey key, unsigned *pIdx) {
+        typename TDb::const_iterator iter = db.find(key);
+        if (db.end() == iter)
+            return false;
+
+        *pIdx = iter->second;
+        return true;
+    }
+
+    template <class TDb, class TKey>
+    void dbInsert(TDb &db, TKey key, unsigned idx) {
+        db[key] = idx;
+    }
+
+    bool dbFind(const UidIndex &db, int uid, unsigned *pIdx) {
+        return db.find(uid, pIdx);
+    }
+
+    void dbInsert(UidIndex &db, int uid, unsigned idx) {
+        db.insert(uid, idx);
+    }
+
     /**
      * Look for an existing value, create a new one if not found.
      * @param db Mapping from key to index.
@@ -47,14 +133,14 @@ namespace {
              const typename TTab::value_type &tpl
                  = typename TTab::value_type())
     {
-        typename TDb::iterator iter = db.find(key);
-        if (db.end() != iter)
+        unsigned idx;
+        if (dbFind(db, key, &idx))
             // key found
-            return idxTab[iter->second];
+            return idxTab[idx];
 
         // allocate a new item
-        unsigned idx = idxTab.size();
-        db[key] = idx;
+        idx = idxTab.size();
+        dbInsert(db, key, idx);
         idxTab.push_back(tpl);
         return idxTab[idx];
     }
@@ -69,13 +155,13 @@ namespace {
     const typename TTab::value_type&
     dbConstLookup(const TDb &db, const TTab &idxTab, TKey key)
     {
-        typename TDb::const_iterator iter = db.find(key);
-        if (db.end() == iter) {
+        unsigned idx;
+        if (!dbFind(db, key, &idx)) {
             CL_BREAK_IF("can't insert anything into const object");
             return idxTab.front();
         }
 
-        return idxTab[iter->second];
+        return idxTab[idx];
     }
 }
 
@@ -157,8 +243,7 @@ bool isOnStack(const Var &var) {
 // /////////////////////////////////////////////////////////////////////////////
 // VarDb implementation
 struct VarDb::Private {
-    typedef std::map<int, unsigned> TMap;
-    TMap db;
+    UidIndex db;
 };
 
 VarDb::VarDb():
@@ -186,13 +271,15 @@ const Var& VarDb::operator[](int uid) const {
 // /////////////////////////////////////////////////////////////////////////////
 // TypeDb implementation
 struct TypeDb::Private {
-    typedef std::map<int, const struct cl_type *> TMap;
-    TMap db;
+    UidIndex db;
 
     int codePtrSizeof;
     int dataPtrSizeof;
     const struct cl_type *genericDataPtr;
 
+    /// canonical representatives by index, computed once needed
+    std::vector<const struct cl_type *> reprs;
+
     Private():
         codePtrSizeof(-1),
         dataPtrSizeof(-1),
@@ -202,6 +289,7 @@ struct TypeDb::Private {
 
     static void updatePtrSizeof(int size, int *pField);
     void digPtrSizeof(const struct cl_type *);
+    void hashCons(const std::vector<const struct cl_type *> &types);
 };
 
 TypeDb::TypeDb():
@@ -244,16 +332,18 @@ bool TypeDb::insert(const struct cl_type *clt) {
     }
     const int uid = clt->uid;
 
-    typedef Private::TMap TDb;
-    TDb &db = d->db;
-    TDb::iterator iter = db.find(uid);
-    if (db.end() != iter)
+    UidIndex &db = d->db;
+    unsigned idx;
+    if (db.find(uid, &idx))
         return false;
 
     // insert type into db
-    db[uid] = clt;
+    db.insert(uid, types_.size());
     types_.push_back(clt);
 
+    // the canonical representatives need to be computed again
+    d->reprs.clear();
+
     d->digPtrSizeof(clt);
     return true;
 }
@@ -270,6 +360,129 @@ const struct cl_type* TypeDb::genericDataPtr() const {
     return d->genericDataPtr;
 }
 
+namespace {
+    typedef std::vector<long>                       TTypeSig;
+
+    struct TypeSigHash {
+        size_t operator()(const TTypeSig &sig) const {
+            size_t hash = sig.size();
+            BOOST_FOREACH(const long num, sig)
+                hash = 31 * hash + static_cast<size_t>(num);
+
+            return hash;
+        }
+    };
+
+    typedef std::unordered_map<TTypeSig, unsigned, TypeSigHash> TSigDb;
+}
+
+/// partition the types into classes of structurally equal ones
+void TypeDb::Private::hashCons(const std::vector<const struct cl_type *> &types)
+{
+    const unsigned cnt = types.size();
+
+    // item names are compared by their ids
+    std::map<std::string, long> nameIds;
+
+    // local part of the signatures, it does not change while refining
+    std::vector<TTypeSig> local(cnt);
+    for (unsigned idx = 0; idx < cnt; ++idx) {
+        const struct cl_type *clt = types[idx];
+        TTypeSig &sig = local[idx];
+        sig.push_back(clt->code);
+        sig.push_back(clt->size);
+        sig.push_back(clt->is_unsigned);
+        sig.push_back(clt->item_cnt);
+
+        switch (clt->code) {
+            case CL_TYPE_UNKNOWN:
+            case CL_TYPE_STRING:
+                // operator==(const cl_type &, const cl_type &) matches these
+                // only by uid
+                sig.push_back(clt->uid);
+                break;
+
+            default:
+                break;
+        }
+
+        for (int i = 0; i < clt->item_cnt; ++i) {
+            const struct cl_type_item *item = clt->items + i;
+            sig.push_back(item->offset);
+
+            long nameId = /* anonymous */ -1L;
+            if (item->name) {
+                const long next = nameIds.size();
+                nameId = nameIds.insert(std::make_pair(item->name, next))
+                    .first->second;
+            }
+
+            sig.push_back(nameId);
+        }
+    }
+
+    // start with all types in a single class and refine until it stabilizes
+    std::vector<unsigned> classOf(cnt, 0U);
+    unsigned cntClasses = 1U;
+    for (;;) {
+        TSigDb sigDb;
+        std::vector<unsigned> next(cnt);
+        for (unsigned idx = 0; idx < cnt; ++idx) {
+            const struct cl_type *clt = types[idx];
+            TTypeSig sig(local[idx]);
+            sig.push_back(classOf[idx]);
+
+            for (int i = 0; i < clt->item_cnt; ++i) {
+                const struct cl_type *cltItem = clt->items[i].type;
+                unsigned idxItem;
+                if (cltItem && this->db.find(cltItem->uid, &idxItem)
+                        && types[idxItem] == cltItem)
+                {
+                    sig.push_back(classOf[idxItem]);
+                    continue;
+                }
+
+                // not indexed by us, match it only with itself
+                sig.push_back(/* foreign */ -1L);
+                sig.push_back(reinterpret_cast<long>(cltItem));
+            }
+
+            const unsigned id = sigDb.size();
+            next[idx] = sigDb.insert(std::make_pair(sig, id)).first->second;
+        }
+
+        classOf.swap(next);
+        if (sigDb.size() == cntClasses)
+            // no class has been split
+            break;
+
+        cntClasses = sigDb.size();
+    }
+
+    // the first type of each class represents the whole class
+    std::vector<const struct cl_type *> reprByClass(cntClasses, 0);
+    this->reprs.resize(cnt);
+    for (unsigned idx = 0; idx < cnt; ++idx) {
+        const struct cl_type *&repr = reprByClass[classOf[idx]];
+        if (!repr)
+            repr = types[idx];
+
+        this->reprs[idx] = repr;
+    }
+}
+
+const struct cl_type* TypeDb::canonical(const struct cl_type *clt) const {
+    unsigned idx;
+    if (!clt || !d->db.find(clt->uid, &idx) || types_[idx] != clt)
+        // not indexed by us
+        return clt;
+
+    if (d->reprs.empty())
+        d->hashCons(types_);
+
+    return d->reprs[idx];
+}
+
 void readTypeTree(TypeDb &db, const struct cl_type *clt) {
     if (!clt) {
 #if 0
@@ -294,10 +507,8 @@ void readTypeTree(TypeDb &db, const struct cl_type *clt) {
 }
 
 const struct cl_type* TypeDb::operator[](int uid) const {
-    typedef Private::TMap TDb;
-    TDb &db = d->db;
-    TDb::iterator iter = db.find(uid);
-    if (db.end() == iter) {
+    unsigned idx;
+    if (!d->db.find(uid, &idx)) {
         CL_DEBUG("TypeDb::insert() is unable to find the required cl_type: #"
                 << uid);
 
@@ -306,7 +517,7 @@ const struct cl_type* TypeDb::operator[](int uid) const {
         return 0;
     }
 
-    return iter->second;
+    return types_[idx];
 }
 
 
@@ -324,10 +535,27 @@ void Block::append(Insn *insn) {
     insns_.push_back(insn);
 }
 
+void Block::remove(const std::set<const Insn *> &insns) {
+    TList kept;
+    BOOST_FOREACH(const Insn *insn, insns_)
+        if (!hasKey(insns, insn))
+            kept.push_back(insn);
+
+    CL_BREAK_IF(kept.empty() || kept.back() != insns_.back());
+    insns_.swap(kept);
+}
+
 void Block::appendPredecessor(Block *pred) {
     inbound_.push_back(pred);
 }
 
+void Block::removePredecessor(const Block *pred) {
+    const TTargetList::iterator it =
+        std::find(inbound_.begin(), inbound_.end(), pred);
+    CL_BREAK_IF(inbound_.end() == it);
+    inbound_.erase(it);
+}
+
 const Insn* Block::front() const {
     CL_BREAK_IF(insns_.empty());
     return insns_.front();
@@ -365,6 +593,7 @@ bool Block::isLoopEntry() const {
 struct ControlFlow::Private {
     typedef std::map<std::string, unsigned> TMap;
     TMap db;
+    TTargetList rpo;
 };
 
 ControlFlow::ControlFlow():
@@ -407,6 +636,31 @@ const Block* ControlFlow::operator[](const char *name) const {
     return dbConstLookup(d->db, bbs_, name);
 }
 
+void ControlFlow::remove(const std::set<const Block *> &bbs) {
+    CL_BREAK_IF(bbs_.empty() || hasKey(bbs, bbs_[0]));
+
+    TList kept;
+    d->db.clear();
+    d->rpo.clear();
+    BOOST_FOREACH(Block *bb, bbs_) {
+        if (hasKey(bbs, bb))
+            continue;
+
+        d->db[bb->name()] = kept.size();
+        kept.push_back(bb);
+    }
+
+    bbs_.swap(kept);
+}
+
+const TTargetList& ControlFlow::rpo() const {
+    return d->rpo;
+}
+
+void ControlFlow::setRpo(const TTargetList &rpo) {
+    d->rpo = rpo;
+}
+
 
 // /////////////////////////////////////////////////////////////////////////////
 // Fnc implementation
@@ -444,8 +698,7 @@ bool isDefined(const Fnc &fnc) {
 // /////////////////////////////////////////////////////////////////////////////
 // FncDb implementation
 struct FncDb::Private {
-    typedef std::map<int, unsigned> TMap;
-    TMap db;
+    UidIndex db;
 };
 
 FncDb::FncDb():
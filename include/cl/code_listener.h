@@ -931,6 +931,122 @@ void cl_chain_append(
         struct cl_code_listener         *chain,
         struct cl_code_listener         *listener);
 
+/**
+ * code model previously serialized by the @b "dump" code listener
+ */
+struct cl_code_model;
+
+/**
+ * map a code model file created by the @b "dump" code listener into memory
+ * @param file_name Name of the file to load.
+ * @return Returns on heap allocated cl_code_model object, or NULL on error.
+ */
+struct cl_code_model* cl_code_model_load(const char *file_name);
+
+/**
+ * replay the loaded code model into the given listener
+ * @param model Object returned by cl_code_model_load() function.
+ * @param listener The listener to feed, the sequence of callbacks is the same
+ * as it was seen by the @b "dump" code listener, but acknowledge is @b not
+ * called.  This allows to replay more models into a single listener.
+ * @note The data given to listener stay valid until cl_code_model_free() is
+ * called, so the listener has to be destroyed before the model is freed.
+ * @return Returns true on success, false if the model is corrupted.
+ */
+bool cl_code_model_replay(
+        struct cl_code_model            *model,
+        struct cl_code_listener         *listener);
+
+/**
+ * link code models created by separate runs of the compiler into one program
+ * and replay it into the given listener
+ * @param models Objects returned by cl_code_model_load() function, each of
+ * them can be linked only into a single program.
+ * @param cnt Count of the models, there is nothing to link if it is one.
+ * @param listener The listener to feed, the models are replayed in the given
+ * order as by cl_code_model_replay(), but types, variables and functions are
+ * given new uids, which are unique across the models.  Global variables and
+ * functions are resolved by name, a global variable is represented by its
+ * definition (the initialized one, if any) in all the models.
+ * @note The data given to listener stay valid until all the models are freed.
+ * @return Returns true on success, false if any of the models is corrupted.
+ */
+bool cl_code_model_link(
+        struct cl_code_model            *const models[],
+        int                             cnt,
+        struct cl_code_listener         *listener);
+
+/**
+ * unmap the code model and free all data created by cl_code_model_replay()
+ */
+void cl_code_model_free(struct cl_code_model *model);
+
+/**
+ * type of function that analyzes a single code model on the server side
+ * @param model_file Name of the file containing the code model, it is valid
+ * only while the function is running.
+ * @param args Analyzer args as given by the client.
+ * @return Returns the exit status reported back to the client.
+ */
+typedef int (*cl_code_model_handler)(const char *model_file, const char *args);
+
+/**
+ * serve code models sent by cl_code_model_submit() on a Unix domain socket
+ * @param socket_path Where to create the socket, an existing file is removed.
+ * @param workers Maximal count of requests being processed concurrently.
+ * @param handler Function called for each request.  It runs in a process
+ * forked from the server, so that no state leaks from one request to another.
+ * Messages written to stderr by the handler are sent to the client once the
+ * handler returns.
+ * @note The server keeps the results of the recent requests (see
+ * CL_SERVER_CACHE_SIZE in config_cl.h).  A request with the same analyzer args
+ * and the same code model as one of them is answered without running the
+ * handler again, e.g. when an unchanged source file is compiled again.
+ * @note The function returns once the server gets SIGINT or SIGTERM and all
+ * pending requests are finished.
+ * @return Returns zero on success, non-zero if the server could not start.
+ */
+int cl_code_model_serve(
+        const char                      *socket_path,
+        int                             workers,
+        cl_code_model_handler           handler);
+
+/**
+ * send a code model to the server started by cl_code_model_serve() and wait
+ * for the analysis to finish, messages of the analysis are written to stderr
+ * @param socket_path Path to the Unix domain socket of the server.
+ * @param model_file Code model created by the @b "dump" code listener.
+ * @param args Analyzer args passed to the handler, no newlines allowed.
+ * @return Returns the exit status of the handler, or -1 on communication error.
+ */
+int cl_code_model_submit(
+        const char                      *socket_path,
+        const char                      *model_file,
+        const char                      *args);
+
+/**
+ * type of function that creates the code listener running the analyzer
+ * @param config_string The same as for cl_code_listener_create().
+ */
+typedef struct cl_code_listener* (*cl_code_listener_factory)(
+        const char                      *config_string);
+
+/**
+ * standalone runner of an analyzer linked in statically, no compiler involved
+ * @param argc The same as given to main().
+ * @param argv The same as given to main().  The code models given on the
+ * command-line are linked into one program and analyzed.  With -s SOCKET, the
+ * code models sent by cl_code_model_submit() are served instead, see
+ * cl_code_model_serve() for details.
+ * @param factory Function used to create the listener for each analysis,
+ * usually cl_code_listener_create().
+ * @return Returns the exit status to be returned by main().
+ */
+int cl_code_model_run(
+        int                             argc,
+        char                            *argv[],
+        cl_code_listener_factory        factory);
+
 #ifdef __cplusplus
 }
 #endif
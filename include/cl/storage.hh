@@ -245,6 +245,16 @@ class TypeDb {
         /// a (void *) type if available; if not, any data pointer; 0 otherwise
         const struct cl_type* genericDataPtr() const;
 
+        /**
+         * canonical representative of the given type, all types indexed by
+         * this container that are structurally equal map to the same one
+         * @note two types with the same representative are equal by means of
+         * operator==(const cl_type &, const cl_type &), so the comparison of
+         * representatives can be used to bypass the deep check.
+         * @note Types not indexed by this container are returned as they are.
+         */
+        const struct cl_type* canonical(const struct cl_type *) const;
+
     private:
         /// @b not allowed to be copied
         TypeDb(const TypeDb &);
@@ -436,6 +446,36 @@ struct Insn {
     std::vector<unsigned>       loopClosingTargets;
 };
 
+/**
+ * position of a basic block in the loop-nesting forest of its ControlFlow graph
+ * @note computed by findLoopClosingEdges(), see loopscan.hh
+ */
+struct LoopInfo {
+    /// index of the block in reverse post-order of the CFG, -1 if unreachable
+    int                         rpoIdx;
+
+    /// true if the block is the header of a loop
+    bool                        isHeader;
+
+    /// true if the block is the header of a loop with more than one entry
+    bool                        isIrreducible;
+
+    /// header of the innermost loop containing the block (except itself)
+    const Block                *parent;
+
+    /// count of loops containing the block (including its own loop if any)
+    unsigned                    depth;
+
+    LoopInfo():
+        rpoIdx(-1),
+        isHeader(false),
+        isIrreducible(false),
+        parent(0),
+        depth(0)
+    {
+    }
+};
+
 /**
  * Basic block - a single node in ControlFlow graph. Once the basic block is
  * ready, it contains (possibly empty) sequence of non-terminating instructions
@@ -488,8 +528,18 @@ class Block {
          */
         void append(Insn *insn);
 
+        /**
+         * remove the given instructions from the block
+         * @note Removed objects are not destroyed, see append() for details
+         * @attention The terminal instruction of the block cannot be removed.
+         */
+        void remove(const std::set<const Insn *> &insns);
+
         void appendPredecessor(Block *);
 
+        /// remove one occurrence of the given block from the predecessors
+        void removePredecessor(const Block *);
+
         /**
          * return list of all direct successors
          */
@@ -542,11 +592,17 @@ class Block {
         /// return true, if a loop at the level of CFG starts with this block
         bool isLoopEntry() const;
 
+        /// position of the block in the loop-nesting forest of its CFG
+        const LoopInfo& loopInfo() const           { return loopInfo_;      }
+
+        void setLoopInfo(const LoopInfo &li)       { loopInfo_ = li;        }
+
     private:
         TList insns_;
         TTargetList inbound_;
         ControlFlow *cfg_;
         std::string name_;
+        LoopInfo loopInfo_;
 };
 
 /**
@@ -590,6 +646,13 @@ class ControlFlow {
          */
         const Block* operator[](const char *name) const;
 
+        /**
+         * remove the given basic blocks from the control flow graph
+         * @note Removed objects are not destroyed, see operator[] for details
+         * @attention The entry basic block cannot be removed.
+         */
+        void remove(const std::set<const Block *> &bbs);
+
         /**
          * return STL-like iterator to go through all basic blocks inside
          */
@@ -605,6 +668,14 @@ class ControlFlow {
          */
         size_t size()                         const { return bbs_.size();  }
 
+        /**
+         * basic blocks reachable from the entry in reverse post-order
+         * @note computed by findLoopClosingEdges(), see loopscan.hh
+         */
+        const TTargetList& rpo() const;
+
+        void setRpo(const TTargetList &);
+
     private:
         TList bbs_;
         struct Private;
@@ -730,18 +801,33 @@ namespace CallGraph {
         /// insns that take address of this function, zero key means initializer
         TInsnListByFnc              callbacks;
 
+        /// index of the strongly connected component in Graph::sccs
+        int                         scc;
+
+        /// true if the function can call itself directly or indirectly
+        bool                        isRecursive;
+
         Node(Fnc *fnc_):
-            fnc(fnc_)
+            fnc(fnc_),
+            scc(-1),
+            isRecursive(false)
         {
         }
     };
 
     typedef std::set<Node *>                        TNodeList;
+    typedef std::vector<Node *>                     TSccNodes;
 
     struct Graph {
         TNodeList                   roots;
         TNodeList                   leaves;
 
+        /**
+         * strongly connected components with respect to direct calls, any
+         * callee comes before its callers unless they are in the same one
+         */
+        std::vector<TSccNodes>      sccs;
+
         bool                        hasIndirectCall;
         bool                        hasCallback;
 
@@ -28,11 +28,15 @@
 #include "symbt.hh"
 #include "symdump.hh"
 #include "symexec.hh"
+#include "symportfolio.hh"
 #include "symproc.hh"
+#include "symreach.hh"
 #include "symstate.hh"
 #include "symtrace.hh"
 #include "util.hh"
 
+#include <algorithm>
+#include <cstdlib>
 #include <string>
 
 #include <boost/foreach.hpp>
@@ -41,7 +45,7 @@
 extern "C" { int plugin_is_GPL_compatible; }
 
 // FIXME: the implementation is amusing
-void parseConfigString(SymExecParams &sep, std::string cnf) {
+void handleConfigItem(SymExecParams &sep, const std::string &cnf) {
     using std::string;
     if (cnf.empty())
         return;
@@ -58,8 +62,6 @@ void parseConfigString(SymExecParams &sep, std::string cnf) {
         return;
     }
 
-    // TODO: make it possible to handle both parameters together (comma
-    // separated list or whatever)
     // TODO: document all the parameters somewhere
     if (string("noplot") == cnf) {
         CL_DEBUG("parseConfigString: \"noplot\" mode requested");
@@ -83,9 +85,72 @@ void parseConfigString(SymExecParams &sep, std::string cnf) {
         return;
     }
 
+    if (string("error_label_only") == cnf) {
+        CL_DEBUG("parseConfigString: \"error label reachability only\" mode "
+                "requested");
+        sep.errLabelOnly = true;
+        return;
+    }
+
+    const char *fbPrefix = "fnc_time_budget:";
+    const size_t fbPrefixLen = strlen(fbPrefix);
+    if (!strncmp(cstr, fbPrefix, fbPrefixLen)) {
+        cstr += fbPrefixLen;
+        sep.fncTimeBudget = atof(cstr);
+        CL_DEBUG("parseConfigString: time budget per function is "
+                << sep.fncTimeBudget << " s");
+        return;
+    }
+
+    const char *cbPrefix = "call_time_budget:";
+    const size_t cbPrefixLen = strlen(cbPrefix);
+    if (!strncmp(cstr, cbPrefix, cbPrefixLen)) {
+        cstr += cbPrefixLen;
+        sep.callTimeBudget = atof(cstr);
+        CL_DEBUG("parseConfigString: time budget per call context is "
+                << sep.callTimeBudget << " s");
+        return;
+    }
+
+    const char *pfPrefix = "portfolio:";
+    const size_t pfPrefixLen = strlen(pfPrefix);
+    if (!strncmp(cstr, pfPrefix, pfPrefixLen)) {
+        cstr += pfPrefixLen;
+        sep.portfolio = std::min<unsigned>(atoi(cstr), portfolioSize());
+        CL_DEBUG("parseConfigString: racing " << sep.portfolio
+                << " configuration(s) in portfolio mode");
+        return;
+    }
+
+    // engine policies given as NAME:VALUE
+    const size_t colon = cnf.find(':');
+    if (string::npos != colon) {
+        const string name = cnf.substr(0, colon);
+        const string val = cnf.substr(colon + 1);
+        char *end;
+        const long num = strtol(val.c_str(), &end, 10);
+        if (!val.empty() && !*end && sep.policy.set(name, num)) {
+            CL_DEBUG("parseConfigString: policy " << name << " set to " << num);
+            return;
+        }
+    }
+
     CL_WARN("unhandled config string: \"" << cnf << "\"");
 }
 
+/// parse comma separated list of analyzer args
+void parseConfigString(SymExecParams &sep, const std::string &cnf) {
+    size_t beg = 0;
+    for (;;) {
+        const size_t end = cnf.find(',', beg);
+        handleConfigItem(sep, cnf.substr(beg, end - beg));
+        if (std::string::npos == end)
+            break;
+
+        beg = end + 1;
+    }
+}
+
 void digGlJunk(SymHeap &sh) {
     using namespace CodeStorage;
     TStorRef stor = sh.stor();
@@ -187,12 +252,15 @@ void launchSymExec(const CodeStorage::Storage &stor, const SymExecParams &ep) {
     printMemUsage("execFnc");
 }
 
-// /////////////////////////////////////////////////////////////////////////////
-// see easy.hh for details
-void clEasyRun(const CodeStorage::Storage &stor, const char *configString) {
-    // read parameters of symbolic execution
-    SymExecParams ep;
-    parseConfigString(ep, configString);
+void runSymExec(const CodeStorage::Storage &stor, const SymExecParams &ep) {
+    if (ep.errLabelOnly && !ep.errLabel.empty() && !ep.errLabelReach) {
+        // pre-compute the blocks that can reach the error label
+        const ErrLabelReach reach(stor, ep.errLabel);
+        SymExecParams epReach(ep);
+        epReach.errLabelReach = &reach;
+        runSymExec(stor, epReach);
+        return;
+    }
 
     // run symbolic execution
     launchSymExec(stor, ep);
@@ -209,3 +277,43 @@ void clEasyRun(const CodeStorage::Storage &stor, const char *configString) {
 
     printPeakMemUsage();
 }
+
+struct PortfolioData {
+    const CodeStorage::Storage         &stor;
+    const SymExecParams                &ep;
+
+    PortfolioData(const CodeStorage::Storage &stor_, const SymExecParams &ep_):
+        stor(stor_),
+        ep(ep_)
+    {
+    }
+};
+
+// runs in a worker forked by runPortfolio()
+void runPortfolioJob(unsigned idx, const void *data) {
+    const PortfolioData &pd = *static_cast<const PortfolioData *>(data);
+
+    // override the parameters given by user
+    SymExecParams ep(pd.ep);
+    parseConfigString(ep, portfolioConfig(idx));
+    runSymExec(pd.stor, ep);
+}
+
+// /////////////////////////////////////////////////////////////////////////////
+// see easy.hh for details
+void clEasyRun(const CodeStorage::Storage &stor, const char *configString) {
+    // read parameters of symbolic execution
+    SymExecParams ep;
+    parseConfigString(ep, configString);
+    if (ep.errLabelOnly && ep.errLabel.empty())
+        CL_WARN("error_label_only has no effect without error_label:NAME");
+
+    if (1 < ep.portfolio) {
+        // race several configurations against each other
+        const PortfolioData pd(stor, ep);
+        runPortfolio(ep.portfolio, runPortfolioJob, &pd);
+        return;
+    }
+
+    runSymExec(stor, ep);
+}
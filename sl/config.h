@@ -86,6 +86,7 @@
 
 /**
  * if 1, perform abstraction after each just completed call on @b caller's side
+ * @note default only, use abstract_on_call_done:N in analyzer args to override
  */
 #define SE_ABSTRACT_ON_CALL_DONE            1
 
@@ -94,6 +95,29 @@
  */
 #define SE_ABSTRACT_ON_LOOP_EDGES_ONLY      1
 
+/**
+ * - 0 ... attempt join on each insertion into the state of a basic block
+ * - 1 ... stop attempting three-way join at blocks where it keeps failing
+ * - 2 ... as 1, and fall back to the isomorphism check at blocks where even
+ *         the ordinary join keeps failing
+ * @note default only, use adaptive_join:N in analyzer args to override
+ * @note 1 and 2 may change the shape of the resulting states, which has not
+ * been checked against the expected outputs of the tests yet
+ */
+#define SE_ADAPTIVE_JOIN                    0
+
+/**
+ * count of failed join attempts in a row that switch off join (or three-way
+ * join) at a basic block, see SE_ADAPTIVE_JOIN
+ */
+#define SE_ADAPTIVE_JOIN_FAIL_STREAK        0x20
+
+/**
+ * while switched off, join is still attempted on each Nth insertion into the
+ * state of a basic block, see SE_ADAPTIVE_JOIN
+ */
+#define SE_ADAPTIVE_JOIN_RETRY              0x10
+
 /*
  * if non-zero, allow incomplete discovery paths with lower costs to apply
  */
@@ -104,6 +128,7 @@
  * - 0x1 ... allow to create integral ranges from integral constants if needed
  * - 0x2 ... allow widening of the upper bound of integral ranges
  * - 0x4 ... allow widening of the lower bound of integral ranges
+ * @note default only, use allow_int_ranges:N in analyzer args to override
  */
 #define SE_ALLOW_INT_RANGES                 0x6
 
@@ -121,6 +146,7 @@
  * - 1 ... only when joining prototypes
  * - 2 ... also when joining states if the three-way join is considered useful
  * - 3 ... do not restrict the usage of three-way join at the level of symjoin
+ * @note default only, use allow_three_way_join:N in analyzer args to override
  */
 #define SE_ALLOW_THREE_WAY_JOIN             2
 
@@ -134,14 +160,41 @@
  * - 1 ... use DFS scheduler, keep already scheduled blocks at their position
  * - 2 ... use DFS scheduler, move already scheduled blocks to front of queue
  * - 3 ... use load-driven scheduler (picks the one with fewer pending heaps)
+ * @note default only, use block_scheduler_kind:N in analyzer args to override
  */
 #define SE_BLOCK_SCHEDULER_KIND             2
 
+/**
+ * maximal count of call contexts cached per function (0 means unlimited)
+ * @note default only, use call_cache_max_ctx_per_fnc:N in analyzer args
+ */
+#define SE_CALL_CACHE_MAX_CTX_PER_FNC       0
+
+/**
+ * maximal count of heaps (entries plus cached results) held by the call cache
+ * in total (0 means unlimited); least recently used contexts are evicted first
+ * @note default only, use call_cache_max_heaps:N in analyzer args to override
+ */
+#define SE_CALL_CACHE_MAX_HEAPS             0
+
 /**
  * call cache miss count that will trigger function removal (0 means disabled)
  */
 #define SE_CALL_CACHE_MISS_THR              0x10
 
+/**
+ * default CPU time budget (in seconds) of a single call context, time spent in
+ * the callees is not included (0 means unlimited); see call_time_budget:SEC
+ */
+#define SE_CALL_TIME_BUDGET                 0
+
+/**
+ * once a basic block has no heaps pending for execution, keep its state as a
+ * compact image if there are at least N heaps in it (0 means never)
+ */
+#define SE_COLD_STATE_MIN_HEAPS             0x10
+
+
 /**
  * increase the cost of abstraction path consisting of concrete objects only by
  */
@@ -184,6 +237,7 @@
  * - 0 ... call cache completely disabled (saves a lot of memory)
  * - 1 ... call cache enabled, use graph isomorphism for lookup (hungry on mem)
  * - 2 ... call cache enabled, use join operator for lookup [experimental]
+ * @note default only, use enable_call_cache:N in analyzer args to override
  */
 #define SE_ENABLE_CALL_CACHE                1
 
@@ -199,11 +253,29 @@
  */
 #define SE_INT_ARITHMETIC_LIMIT             8
 
+/**
+ * default CPU time budget (in seconds) of a function, summed over all its call
+ * contexts, time spent in the callees is not included (0 means unlimited); see
+ * fnc_time_budget:SEC
+ */
+#define SE_FNC_TIME_BUDGET                  0
+
+/**
+ * - 0 ... execute each instruction on all heaps of the state, then go next
+ * - 1 ... run each heap through a whole straight-line segment of a basic block
+ *         (no calls, no conditional jumps) before the next heap is taken
+ * @note default only, use fused_block_segments:N in analyzer args to override
+ * @note 1 reorders the messages reported within a segment (heap by heap rather
+ * than insn by insn), which does not match the expected outputs of the tests
+ */
+#define SE_FUSED_BLOCK_SEGMENTS             0
+
 /**
  * - 0 ... join states on each basic block entry
  * - 1 ... join only when traversing a loop-closing edge, entailment otherwise
  * - 2 ... join only when traversing a loop-closing edge, isomorphism otherwise
  * - 3 ... same as 2 but skips the isomorphism check when considered redundant
+ * @note default only, use join_on_loop_edges_only:N in analyzer args to override
  */
 #define SE_JOIN_ON_LOOP_EDGES_ONLY          3
 
@@ -250,6 +322,7 @@
  * - 1 ... keep state info for all basic blocks except trivial basic blocks
  * - 2 ... keep state info for all basic blocks with more than one ingoing edge
  * - 3 ... keep state info for all basic blocks that a CFG loop starts with
+ * @note default only, use state_pruning_mode:N in analyzer args to override
  */
 #define SE_STATE_PRUNING_MODE               1
 
@@ -278,6 +351,13 @@
  */
 #define SE_TRACK_NON_POINTER_VALUES         2
 
+/**
+ * renumber the entities of a heap being inserted into a state if less than 1/N
+ * of its IDs is still in use, only heaps with at least 0x40 IDs are considered
+ * (0 means never renumber the entities)
+ */
+#define SH_COMPACT_IDS_THR                  2
+
 /**
  * if 1, do not make deep copy on copy of SymHeap [experimental]
  */
@@ -61,6 +61,12 @@ class IntervalArena {
             cont_.clear();
         }
 
+        /// replace each object by objMap(obj), objMap has to preserve order
+        template <class TMapper> void renumber(const TMapper &objMap);
+
+        /// return all (key, object) pairs stored in the arena
+        void items(std::vector<value_type> &dst) const;
+
         IntervalArena& operator+=(const value_type &item) {
             this->add(item.first, item.second);
             return *this;
@@ -72,6 +78,35 @@ class IntervalArena {
         }
 };
 
+template <typename TInt, typename TObj>
+template <class TMapper>
+void IntervalArena<TInt, TObj>::renumber(const TMapper &objMap)
+{
+    BOOST_FOREACH(typename TCont::reference item, cont_) {
+        BOOST_FOREACH(typename TLine::reference lineItem, item.second) {
+            TLeaf &leaf = lineItem.second;
+            TLeaf dst;
+            BOOST_FOREACH(const TObj obj, leaf)
+                dst.insert(dst.end(), objMap(obj));
+
+            leaf.swap(dst);
+        }
+    }
+}
+
+template <typename TInt, typename TObj>
+void IntervalArena<TInt, TObj>::items(std::vector<value_type> &dst) const
+{
+    BOOST_FOREACH(typename TCont::const_reference item, cont_) {
+        const TInt end = item.first;
+        BOOST_FOREACH(typename TLine::const_reference lineItem, item.second) {
+            const key_type key(/* beg */ lineItem.first, end);
+            BOOST_FOREACH(const TObj obj, lineItem.second)
+                dst.push_back(value_type(key, obj));
+        }
+    }
+}
+
 template <typename TInt, typename TObj>
 void IntervalArena<TInt, TObj>::add(const key_type &key, const TObj obj)
 {
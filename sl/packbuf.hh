@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2012 Kamil Dudka <kdudka@redhat.com>
+ *
+ * This file is part of predator.
+ *
+ * predator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * predator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with predator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_GUARD_PACKBUF_H
+#define H_GUARD_PACKBUF_H
+
+/**
+ * @file packbuf.hh
+ * PackWriter and PackReader - compact in-memory images of data structures
+ *
+ * Integers are stored as variable-length quantities (7 bits per byte), signed
+ * integers are zig-zag encoded first, so that small negative numbers take one
+ * byte, too.  Ordered sets of integers are stored as differences between the
+ * neighbouring items.  The images are meant to live within a single process,
+ * so pointers are stored as they are.
+ */
+
+#include "config.h"
+
+#include <cl/cl_msg.hh>
+
+#include <cstring>
+#include <string>
+
+#include <boost/foreach.hpp>
+
+class PackWriter {
+    public:
+        /// the encoded data are appended to dst
+        PackWriter(std::string &dst):
+            dst_(dst)
+        {
+        }
+
+        void putUInt(unsigned long num) {
+            while (0x80UL <= num) {
+                dst_.push_back(static_cast<char>(0x80UL | (num & 0x7FUL)));
+                num >>= 7;
+            }
+
+            dst_.push_back(static_cast<char>(num));
+        }
+
+        void putInt(long num) {
+            const unsigned long bits = num;
+            this->putUInt((num < 0)
+                    ? ~(bits << 1)
+                    :  (bits << 1));
+        }
+
+        void putReal(const double fpn) {
+            dst_.append(reinterpret_cast<const char *>(&fpn), sizeof fpn);
+        }
+
+        void putPtr(const void *ptr) {
+            dst_.append(reinterpret_cast<const char *>(&ptr), sizeof ptr);
+        }
+
+        /// store an ordered set of integers, the order is given by the set
+        template <class TSet>
+        void putSet(const TSet &set) {
+            this->putUInt(set.size());
+
+            long last = 0L;
+            BOOST_FOREACH(const typename TSet::value_type item, set) {
+                const long num = item;
+                this->putInt(num - last);
+                last = num;
+            }
+        }
+
+    private:
+        std::string        &dst_;
+};
+
+class PackReader {
+    public:
+        /// read the data encoded by PackWriter, starting at the given position
+        PackReader(const std::string &src, size_t pos = 0):
+            src_(src),
+            pos_(pos)
+        {
+        }
+
+        /// position of the data not read yet
+        size_t pos() const {
+            return pos_;
+        }
+
+        bool atEnd() const {
+            return src_.size() <= pos_;
+        }
+
+        unsigned long getUInt() {
+            unsigned long num = 0UL;
+            for (int shift = 0;; shift += 7) {
+                CL_BREAK_IF(this->atEnd());
+                const unsigned long byte =
+                    static_cast<unsigned char>(src_[pos_++]);
+
+                num |= (byte & 0x7FUL) << shift;
+                if (!(0x80UL & byte))
+                    return num;
+            }
+        }
+
+        long getInt() {
+            const unsigned long bits = this->getUInt();
+            return (bits & 1UL)
+                ? static_cast<long>(~(bits >> 1))
+                : static_cast<long>(  bits >> 1);
+        }
+
+        double getReal() {
+            double fpn;
+            this->getRaw(&fpn, sizeof fpn);
+            return fpn;
+        }
+
+        template <typename TPtr>
+        TPtr getPtr() {
+            TPtr ptr;
+            this->getRaw(&ptr, sizeof ptr);
+            return ptr;
+        }
+
+        /// read a set of integers stored by PackWriter::putSet()
+        template <class TSet>
+        void getSet(TSet &dst) {
+            typedef typename TSet::value_type TItem;
+
+            long num = 0L;
+            for (unsigned long cnt = this->getUInt(); cnt; --cnt) {
+                num += this->getInt();
+                dst.insert(dst.end(), static_cast<TItem>(num));
+            }
+        }
+
+    private:
+        const std::string  &src_;
+        size_t              pos_;
+
+        void getRaw(void *dst, size_t size) {
+            CL_BREAK_IF(src_.size() < pos_ + size);
+            memcpy(dst, src_.data() + pos_, size);
+            pos_ += size;
+        }
+};
+
+#endif /* H_GUARD_PACKBUF_H */
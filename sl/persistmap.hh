@@ -0,0 +1,487 @@
+/*
+ * Copyright (C) 2012 Kamil Dudka <kdudka@redhat.com>
+ *
+ * This file is part of predator.
+ *
+ * predator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * predator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with predator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_GUARD_PERSISTMAP_H
+#define H_GUARD_PERSISTMAP_H
+
+/**
+ * @file persistmap.hh
+ * PersistentMap and PersistentSet - ordered containers with O(1) copy
+ *
+ * Copies of a container share all the tree nodes.  A write into a copy clones
+ * only the nodes on the path from root to the modified node, the rest of the
+ * tree remains shared.  Nodes owned by a single container are updated in
+ * place, so a container that is never copied behaves like a plain AVL tree.
+ */
+
+#include "config.h"
+
+#include <cl/cl_msg.hh>
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <utility>
+
+/// extracts the key from items of PersistentMap
+template <class TItem>
+struct PersistentKeyOfPair {
+    typedef typename TItem::first_type              TKey;
+    const TKey& operator()(const TItem &item) const { return item.first; }
+};
+
+/// extracts the key from items of PersistentSet
+template <class TItem>
+struct PersistentKeyOfItem {
+    typedef TItem                                   TKey;
+    const TKey& operator()(const TItem &item) const { return item; }
+};
+
+/// AVL tree with reference-counted nodes, use PersistentMap or PersistentSet
+template <class TItem, class TKeyOf, class TCmp>
+class PersistentTree {
+    public:
+        // for compatibility with STL and Boost libraries
+        typedef typename TKeyOf::TKey               key_type;
+        typedef TItem                               value_type;
+        typedef const TItem&                        const_reference;
+        typedef size_t                              size_type;
+
+    private:
+        struct Node {
+            TItem           item;
+            Node           *left;
+            Node           *right;
+            int             height;
+            int             refCnt;
+
+            Node(const TItem &item_):
+                item(item_),
+                left(0),
+                right(0),
+                height(1),
+                refCnt(1)
+            {
+            }
+        };
+
+        Node               *root_;
+        size_type           size_;
+
+    public:
+        /// in-order iterator, keeps the path from root as it cannot go up
+        class const_iterator {
+            public:
+                // for compatibility with STL and Boost libraries
+                typedef std::forward_iterator_tag   iterator_category;
+                typedef TItem                       value_type;
+                typedef ptrdiff_t                   difference_type;
+                typedef const TItem*                pointer;
+                typedef const TItem&                reference;
+
+            public:
+                const_iterator(): depth_(0) { }
+
+                const TItem& operator*()  const { return  this->top()->item; }
+                const TItem* operator->() const { return &this->top()->item; }
+
+                bool operator==(const const_iterator &ref) const {
+                    if (depth_ != ref.depth_)
+                        return false;
+
+                    return !depth_ || this->top() == ref.top();
+                }
+
+                bool operator!=(const const_iterator &ref) const {
+                    return !operator==(ref);
+                }
+
+                const_iterator& operator++() {
+                    const Node *node = this->top()->right;
+                    if (node) {
+                        this->pushLeftSpine(node);
+                        return *this;
+                    }
+
+                    // go up until we arrive from the left subtree
+                    const Node *prev;
+                    do {
+                        prev = path_[--depth_];
+                    }
+                    while (depth_ && this->top()->right == prev);
+
+                    return *this;
+                }
+
+                const_iterator operator++(int) {
+                    const const_iterator ret(*this);
+                    this->operator++();
+                    return ret;
+                }
+
+            private:
+                /// the height of an AVL tree is below 1.45 * log2(size)
+                enum { MAX_DEPTH = 64 };
+
+                const Node     *path_[MAX_DEPTH];
+                int             depth_;
+
+                const Node* top() const {
+                    CL_BREAK_IF(!depth_);
+                    return path_[depth_ - 1];
+                }
+
+                void push(const Node *node) {
+                    CL_BREAK_IF(MAX_DEPTH <= depth_);
+                    path_[depth_++] = node;
+                }
+
+                void pushLeftSpine(const Node *node) {
+                    for (; node; node = node->left)
+                        this->push(node);
+                }
+
+                friend class PersistentTree;
+        };
+
+        typedef const_iterator                      iterator;
+
+    public:
+        PersistentTree():
+            root_(0),
+            size_(0)
+        {
+        }
+
+        PersistentTree(const PersistentTree &ref):
+            root_(ref.root_),
+            size_(ref.size_)
+        {
+            if (root_)
+                ++root_->refCnt;
+        }
+
+        ~PersistentTree() {
+            release(root_);
+        }
+
+        PersistentTree& operator=(const PersistentTree &ref) {
+            if (ref.root_)
+                ++ref.root_->refCnt;
+
+            release(root_);
+            root_ = ref.root_;
+            size_ = ref.size_;
+            return *this;
+        }
+
+        void swap(PersistentTree &ref) {
+            std::swap(root_, ref.root_);
+            std::swap(size_, ref.size_);
+        }
+
+        bool empty() const {
+            return !root_;
+        }
+
+        size_type size() const {
+            return size_;
+        }
+
+        void clear() {
+            release(root_);
+            root_ = 0;
+            size_ = 0;
+        }
+
+        const_iterator begin() const {
+            const_iterator it;
+            it.pushLeftSpine(root_);
+            return it;
+        }
+
+        const_iterator end() const {
+            return const_iterator();
+        }
+
+        const_iterator find(const key_type &key) const {
+            const_iterator it;
+            for (const Node *node = root_; node;) {
+                it.push(node);
+                const key_type &nodeKey = TKeyOf()(node->item);
+                if (TCmp()(key, nodeKey))
+                    node = node->left;
+                else if (TCmp()(nodeKey, key))
+                    node = node->right;
+                else
+                    return it;
+            }
+
+            return this->end();
+        }
+
+        /// return pointer to the item with the given key, 0 if not found
+        const TItem* lookup(const key_type &key) const {
+            const Node *node = root_;
+            while (node) {
+                const key_type &nodeKey = TKeyOf()(node->item);
+                if (TCmp()(key, nodeKey))
+                    node = node->left;
+                else if (TCmp()(nodeKey, key))
+                    node = node->right;
+                else
+                    return &node->item;
+            }
+
+            return 0;
+        }
+
+        size_type count(const key_type &key) const {
+            return !!this->lookup(key);
+        }
+
+        /// insert the item, or overwrite the one with the same key if any
+        bool insertOrAssign(const TItem &item) {
+            bool inserted = false;
+            root_ = insertAt(root_, item, /* assign */ true, &inserted);
+            size_ += inserted;
+            return inserted;
+        }
+
+        /// insert the item unless there already is one with the same key
+        bool insertOnce(const TItem &item) {
+            if (this->lookup(TKeyOf()(item)))
+                // avoid cloning of the path to an existing item
+                return false;
+
+            bool inserted = false;
+            root_ = insertAt(root_, item, /* assign */ false, &inserted);
+            size_ += inserted;
+            return inserted;
+        }
+
+        size_type erase(const key_type &key) {
+            if (!this->lookup(key))
+                // avoid cloning of the path to a non-existing item
+                return 0;
+
+            root_ = eraseAt(root_, key);
+            --size_;
+            return 1;
+        }
+
+    private:
+        static int heightOf(const Node *node) {
+            return (node)
+                ? node->height
+                : 0;
+        }
+
+        static void release(Node *node) {
+            while (node && !--node->refCnt) {
+                release(node->left);
+                Node *right = node->right;
+                delete node;
+
+                // the right subtree without recursion
+                node = right;
+            }
+        }
+
+        /// take over a reference to node, return an exclusively owned node
+        static Node* exclusive(Node *node) {
+            CL_BREAK_IF(!node || node->refCnt < 1);
+            if (1 == node->refCnt)
+                return node;
+
+            Node *dup = new Node(*node);
+            dup->refCnt = 1;
+            if (dup->left)
+                ++dup->left->refCnt;
+            if (dup->right)
+                ++dup->right->refCnt;
+
+            --node->refCnt;
+            return dup;
+        }
+
+        static void updateHeight(Node *node) {
+            const int hl = heightOf(node->left);
+            const int hr = heightOf(node->right);
+            node->height = 1 + ((hl < hr) ? hr : hl);
+        }
+
+        static Node* rotateRight(Node *node) {
+            Node *left = exclusive(node->left);
+            node->left = left->right;
+            left->right = node;
+            updateHeight(node);
+            updateHeight(left);
+            return left;
+        }
+
+        static Node* rotateLeft(Node *node) {
+            Node *right = exclusive(node->right);
+            node->right = right->left;
+            right->left = node;
+            updateHeight(node);
+            updateHeight(right);
+            return right;
+        }
+
+        /// @param node an exclusively owned node with balanced subtrees
+        static Node* rebalance(Node *node) {
+            const int diff = heightOf(node->left) - heightOf(node->right);
+            if (1 < diff) {
+                Node *left = node->left;
+                if (heightOf(left->left) < heightOf(left->right))
+                    node->left = rotateLeft(exclusive(left));
+
+                return rotateRight(node);
+            }
+
+            if (diff < -1) {
+                Node *right = node->right;
+                if (heightOf(right->right) < heightOf(right->left))
+                    node->right = rotateRight(exclusive(right));
+
+                return rotateLeft(node);
+            }
+
+            updateHeight(node);
+            return node;
+        }
+
+        static Node* insertAt(
+                Node                   *node,
+                const TItem            &item,
+                const bool              assign,
+                bool                   *pInserted)
+        {
+            if (!node) {
+                *pInserted = true;
+                return new Node(item);
+            }
+
+            const key_type &key = TKeyOf()(item);
+            const key_type &nodeKey = TKeyOf()(node->item);
+            if (!TCmp()(key, nodeKey) && !TCmp()(nodeKey, key)) {
+                if (!assign)
+                    return node;
+
+                node = exclusive(node);
+                node->item = item;
+                return node;
+            }
+
+            node = exclusive(node);
+            if (TCmp()(key, nodeKey))
+                node->left = insertAt(node->left, item, assign, pInserted);
+            else
+                node->right = insertAt(node->right, item, assign, pInserted);
+
+            return rebalance(node);
+        }
+
+        /// detach the leftmost item of the subtree and store it to *pDst
+        static Node* eraseMin(Node *node, TItem *pDst) {
+            node = exclusive(node);
+            if (node->left) {
+                node->left = eraseMin(node->left, pDst);
+                return rebalance(node);
+            }
+
+            *pDst = node->item;
+            Node *right = node->right;
+            node->right = 0;
+            release(node);
+            return right;
+        }
+
+        /// @note the key is known to be present in the subtree
+        static Node* eraseAt(Node *node, const key_type &key) {
+            CL_BREAK_IF(!node);
+            node = exclusive(node);
+
+            const key_type &nodeKey = TKeyOf()(node->item);
+            if (TCmp()(key, nodeKey)) {
+                node->left = eraseAt(node->left, key);
+                return rebalance(node);
+            }
+
+            if (TCmp()(nodeKey, key)) {
+                node->right = eraseAt(node->right, key);
+                return rebalance(node);
+            }
+
+            if (!node->left || !node->right) {
+                Node *child = (node->left) ? node->left : node->right;
+                node->left = 0;
+                node->right = 0;
+                release(node);
+                return child;
+            }
+
+            // replace the item by its in-order successor
+            node->right = eraseMin(node->right, &node->item);
+            return rebalance(node);
+        }
+};
+
+/// ordered map with O(1) copy and O(log n) write after copy
+template <class TKey, class TVal, class TCmp = std::less<TKey> >
+class PersistentMap: public PersistentTree<
+    std::pair<TKey, TVal>,
+    PersistentKeyOfPair<std::pair<TKey, TVal> >,
+    TCmp>
+{
+    public:
+        typedef TVal                                mapped_type;
+
+        /// return pointer to the value of the given key, 0 if not found
+        const TVal* findVal(const TKey &key) const {
+            const std::pair<TKey, TVal> *item = this->lookup(key);
+            return (item)
+                ? &item->second
+                : 0;
+        }
+
+        /// define or redefine the value of the given key
+        bool set(const TKey &key, const TVal &val) {
+            return this->insertOrAssign(std::make_pair(key, val));
+        }
+};
+
+/// ordered set with O(1) copy and O(log n) write after copy
+template <class TKey, class TCmp = std::less<TKey> >
+class PersistentSet: public PersistentTree<
+    TKey,
+    PersistentKeyOfItem<TKey>,
+    TCmp>
+{
+    public:
+        /// for compatibility with insertOnce() of util.hh
+        std::pair<typename PersistentSet::const_iterator, bool>
+        insert(const TKey &key) {
+            const bool inserted = this->insertOnce(key);
+            return std::make_pair(this->find(key), inserted);
+        }
+};
+
+#endif /* H_GUARD_PERSISTMAP_H */
@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2012 Kamil Dudka <kdudka@redhat.com>
+ *
+ * This file is part of predator.
+ *
+ * predator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * predator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with predator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file predator-run.cc
+ * standalone runner of the analyzer over code models created by the gcc plug-in
+ * with -fplugin-arg-libsl-dump-model=FILE, no compiler is involved here
+ *
+ * With -s SOCKET, it runs as an analysis server instead, serving the code
+ * models sent by the gcc plug-in with -fplugin-arg-libsl-server=SOCKET.
+ */
+
+#include <cl/code_listener.h>
+
+int main(int argc, char *argv[])
+{
+    return cl_code_model_run(argc, argv, cl_code_listener_create);
+}
@@ -0,0 +1,443 @@
+/*
+ * Copyright (C) 2012 Kamil Dudka <kdudka@redhat.com>
+ *
+ * This file is part of predator.
+ *
+ * predator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * predator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with predator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file symbench.cc
+ * synthetic micro-benchmarks of the SymHeap core operations over a fake
+ * CodeStorage::Storage, neither gcc nor the code listener is needed to run it
+ */
+
+#include "config.h"
+
+#include <cl/code_listener.h>
+#include <cl/cl_msg.hh>
+#include <cl/storage.hh>
+
+#include "symabstract.hh"
+#include "symcmp.hh"
+#include "symcut.hh"
+#include "symgc.hh"
+#include "symheap.hh"
+#include "symjoin.hh"
+#include "symtrace.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <sys/time.h>
+
+#include <boost/foreach.hpp>
+
+// /////////////////////////////////////////////////////////////////////////////
+// fake code model
+
+/// struct node { struct node *next; struct node *prev; struct node *nested; }
+enum {
+    NODE_NEXT       = 0,
+    NODE_PREV       = 1,
+    NODE_NESTED     = 2,
+    NODE_CNT_ITEMS
+};
+
+/// maximal count of items of the array of pointers
+const int ARRAY_SIZE = 0x100;
+
+/// uids of the global variables
+enum {
+    VAR_HEAD = 1,                           ///< struct node *head
+    VAR_AUX,                                ///< struct node *aux
+    VAR_ARRAY                               ///< struct node *array[ARRAY_SIZE]
+};
+
+class FakeStorage {
+    public:
+        FakeStorage();
+
+        TStorRef stor() const { return stor_; }
+
+        TObjType nodeType() const { return &node_; }
+        TObjType ptrType()  const { return &nodePtr_; }
+
+        TOffset off(int item) const { return node_.items[item].offset; }
+
+        TSizeRange nodeSize() const { return IR::rngFromNum(node_.size); }
+
+    private:
+        CodeStorage::Storage        stor_;
+        struct cl_type              void_;
+        struct cl_type              voidPtr_;
+        struct cl_type              node_;
+        struct cl_type              nodePtr_;
+        struct cl_type              array_;
+        struct cl_type_item         voidPtrItem_;
+        struct cl_type_item         nodeItems_[NODE_CNT_ITEMS];
+        struct cl_type_item         nodePtrItem_;
+        struct cl_type_item         arrayItem_;
+
+        void initType(struct cl_type *clt, int uid, enum cl_type_e code,
+                      int size, const char *name = 0);
+
+        void initVar(int uid, const struct cl_type *clt, const char *name);
+};
+
+void FakeStorage::initType(
+        struct cl_type              *clt,
+        int                         uid,
+        enum cl_type_e              code,
+        int                         size,
+        const char                  *name)
+{
+    memset(clt, 0, sizeof *clt);
+    clt->uid        = uid;
+    clt->code       = code;
+    clt->scope      = CL_SCOPE_GLOBAL;
+    clt->name       = name;
+    clt->size       = size;
+}
+
+void FakeStorage::initVar(int uid, const struct cl_type *clt, const char *name)
+{
+    CodeStorage::Var &var = stor_.vars[uid];
+    var.code        = CodeStorage::VAR_GL;
+    var.loc         = cl_loc_unknown;
+    var.type        = clt;
+    var.uid         = uid;
+    var.name        = name;
+    var.initialized = true;
+    var.isExtern    = false;
+    stor_.varNames.glNames[name] = uid;
+}
+
+FakeStorage::FakeStorage() {
+    const int ptrSize = sizeof(void *);
+
+    this->initType(&void_, 1, CL_TYPE_VOID, 1, "void");
+    this->initType(&voidPtr_, 2, CL_TYPE_PTR, ptrSize);
+    voidPtrItem_.type = &void_;
+    voidPtrItem_.name = 0;
+    voidPtrItem_.offset = 0;
+    voidPtr_.item_cnt = 1;
+    voidPtr_.items = &voidPtrItem_;
+
+    this->initType(&node_, 3, CL_TYPE_STRUCT, NODE_CNT_ITEMS * ptrSize, "node");
+    static const char *itemNames[NODE_CNT_ITEMS] = { "next", "prev", "nested" };
+    for (int i = 0; i < NODE_CNT_ITEMS; ++i) {
+        nodeItems_[i].type      = &nodePtr_;
+        nodeItems_[i].name      = itemNames[i];
+        nodeItems_[i].offset    = i * ptrSize;
+    }
+    node_.item_cnt = NODE_CNT_ITEMS;
+    node_.items = nodeItems_;
+
+    this->initType(&nodePtr_, 4, CL_TYPE_PTR, ptrSize);
+    nodePtrItem_.type = &node_;
+    nodePtrItem_.name = 0;
+    nodePtrItem_.offset = 0;
+    nodePtr_.item_cnt = 1;
+    nodePtr_.items = &nodePtrItem_;
+
+    this->initType(&array_, 5, CL_TYPE_ARRAY, ARRAY_SIZE * ptrSize);
+    arrayItem_.type = &nodePtr_;
+    arrayItem_.name = 0;
+    arrayItem_.offset = 0;
+    array_.item_cnt = 1;
+    array_.items = &arrayItem_;
+    array_.array_size = ARRAY_SIZE;
+
+    CodeStorage::readTypeTree(stor_.types, &array_);
+    CodeStorage::readTypeTree(stor_.types, &voidPtr_);
+
+    this->initVar(VAR_HEAD,     &nodePtr_,  "head");
+    this->initVar(VAR_AUX,      &nodePtr_,  "aux");
+    this->initVar(VAR_ARRAY,    &array_,    "array");
+}
+
+// /////////////////////////////////////////////////////////////////////////////
+// heap shapes
+enum EShape {
+    SHAPE_SLL,          ///< singly-linked list
+    SHAPE_DLL,          ///< doubly-linked list
+    SHAPE_NESTED,       ///< singly-linked list of singly-linked lists
+    SHAPE_ARRAY         ///< array of pointers to standalone nodes
+};
+
+const char *shapeNames[] = {
+    "SLL",
+    "DLL",
+    "nested",
+    "array"
+};
+
+/// store the given value to the pointer at the given address and offset
+void storePtr(SymHeap &sh, TValId at, TOffset off, TValId val) {
+    const PtrHandle ptr(sh, sh.valByOffset(at, off));
+    ptr.setValue(val);
+}
+
+/// allocate a new node, all its pointers are initialized to NULL
+TValId allocNode(SymHeap &sh, const FakeStorage &fs) {
+    const TSizeRange size = fs.nodeSize();
+    const TValId node = sh.heapAlloc(size);
+    sh.writeUniformBlock(node, VAL_NULL, size.lo);
+    sh.valSetLastKnownTypeOfTarget(node, fs.nodeType());
+    return node;
+}
+
+/// create a list of the given length, return address of the first node
+TValId buildList(SymHeap &sh, const FakeStorage &fs, int len, bool dll) {
+    TValId first = VAL_NULL;
+    TValId prev = VAL_NULL;
+    for (int i = 0; i < len; ++i) {
+        const TValId node = allocNode(sh, fs);
+        if (VAL_NULL == prev)
+            first = node;
+        else
+            storePtr(sh, prev, fs.off(NODE_NEXT), node);
+
+        if (dll)
+            storePtr(sh, node, fs.off(NODE_PREV), prev);
+
+        prev = node;
+    }
+
+    return first;
+}
+
+/// build a heap of the given shape and size, reachable from the given var
+void buildShape(SymHeap &sh, const FakeStorage &fs, EShape shape, int size,
+                int varUid = VAR_HEAD)
+{
+    TValId first = VAL_NULL;
+    switch (shape) {
+        case SHAPE_SLL:
+        case SHAPE_DLL:
+            first = buildList(sh, fs, size, SHAPE_DLL == shape);
+            break;
+
+        case SHAPE_NESTED:
+            first = buildList(sh, fs, size, /* dll */ false);
+            for (TValId node = first; 0 < node;) {
+                const TValId nested = buildList(sh, fs, size, false);
+                storePtr(sh, node, fs.off(NODE_NESTED), nested);
+
+                const PtrHandle next(sh, sh.valByOffset(node, fs.off(NODE_NEXT)));
+                node = next.value();
+            }
+            break;
+
+        case SHAPE_ARRAY: {
+            const TValId array = sh.addrOfVar(CVar(VAR_ARRAY, 0), true);
+            const TOffset ptrSize = fs.off(NODE_PREV);
+            for (int i = 0; i < size && i < ARRAY_SIZE; ++i)
+                storePtr(sh, array, i * ptrSize, allocNode(sh, fs));
+            return;
+        }
+    }
+
+    const TValId var = sh.addrOfVar(CVar(varUid, 0), true);
+    storePtr(sh, var, 0, first);
+}
+
+// /////////////////////////////////////////////////////////////////////////////
+// benchmark driver
+double now() {
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + 1e-6 * tv.tv_usec;
+}
+
+struct BenchCtx {
+    const FakeStorage               &fs;
+    const SymHeap                   &sh;
+    const SymHeap                   &shLonger;
+    EShape                          shape;
+    int                             size;
+};
+
+typedef void (*TBenchFnc)(const BenchCtx &);
+
+void benchCopy(const BenchCtx &ctx) {
+    const SymHeap copy(ctx.sh);
+    (void) copy;
+}
+
+void benchValClone(const BenchCtx &ctx) {
+    SymHeap copy(ctx.sh);
+    const TValId var = copy.addrOfVar(CVar(VAR_HEAD, 0), false);
+    if (0 < var)
+        copy.valClone(PtrHandle(copy, var).value());
+}
+
+void benchObjSetValue(const BenchCtx &ctx) {
+    // redirect the pointers in the first node to the first node itself
+    SymHeap copy(ctx.sh);
+    const TValId var = copy.addrOfVar(CVar(VAR_HEAD, 0), false);
+    if (var <= 0)
+        return;
+
+    const TValId first = PtrHandle(copy, var).value();
+    for (int i = 0; i < NODE_CNT_ITEMS; ++i)
+        storePtr(copy, first, ctx.fs.off(i), first);
+}
+
+void benchAreEqual(const BenchCtx &ctx) {
+    SymHeap copy(ctx.sh);
+    if (!areEqual(ctx.sh, copy))
+        CL_BREAK_IF("areEqual() malfunction");
+}
+
+void benchJoin(const BenchCtx &ctx) {
+    EJoinStatus status;
+    SymHeap dst(ctx.sh.stor(), new Trace::TransientNode("benchJoin"));
+    joinSymHeaps(&status, &dst, ctx.sh, ctx.shLonger);
+}
+
+void benchAbstract(const BenchCtx &ctx) {
+    SymHeap copy(ctx.sh);
+    abstractIfNeeded(copy);
+}
+
+void benchCollectJunk(const BenchCtx &ctx) {
+    // forget the pointer to the first node and collect the whole structure
+    SymHeap copy(ctx.sh);
+    const TValId var = copy.addrOfVar(CVar(VAR_HEAD, 0), false);
+    if (var <= 0)
+        return;
+
+    const PtrHandle head(copy, var);
+    const TValId first = head.value();
+    head.setValue(VAL_NULL);
+
+    TValList leakList;
+    collectJunk(copy, first, &leakList);
+}
+
+void benchSplit(const BenchCtx &ctx) {
+    TCVarList cut;
+    cut.push_back(CVar(VAR_AUX, 0));
+
+    SymHeap copy(ctx.sh);
+    SymHeap frame(ctx.sh.stor(), new Trace::TransientNode("benchSplit"));
+    splitHeapByCVars(&copy, cut, &frame);
+}
+
+struct BenchDesc {
+    const char                      *name;
+    TBenchFnc                       fnc;
+};
+
+const BenchDesc benchList[] = {
+    { "copy",               benchCopy           },
+    { "valClone",           benchValClone       },
+    { "objSetValue",        benchObjSetValue    },
+    { "areEqual",           benchAreEqual       },
+    { "joinSymHeaps",       benchJoin           },
+    { "abstractIfNeeded",   benchAbstract       },
+    { "collectJunk",        benchCollectJunk    },
+    { "splitHeapByCVars",   benchSplit          }
+};
+
+/// run the given benchmark repeatedly for at least minTime seconds
+double runBench(const BenchDesc &bench, const BenchCtx &ctx, double minTime) {
+    int cnt = 0;
+    const double start = now();
+    double elapsed;
+    do {
+        bench.fnc(ctx);
+        ++cnt;
+    }
+    while ((elapsed = now() - start) < minTime);
+
+    return elapsed / cnt;
+}
+
+void usage(const char *self) {
+    fprintf(stderr, "Usage: %s [-t MIN_TIME_PER_BENCH] [-n MAX_SIZE] "
+            "[BENCH_NAME...]\n", self);
+}
+
+bool selected(const char *name, int argc, char *argv[], int optind) {
+    if (argc <= optind)
+        // no filter given
+        return true;
+
+    for (int i = optind; i < argc; ++i)
+        if (!strcmp(name, argv[i]))
+            return true;
+
+    return false;
+}
+
+int main(int argc, char *argv[]) {
+    double minTime = 0.1;
+    int maxSize = 0x40;
+
+    int i = 1;
+    for (; i < argc && '-' == argv[i][0]; i += 2) {
+        if (argc <= i + 1) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+
+        if (!strcmp("-t", argv[i]))
+            minTime = atof(argv[i + 1]);
+        else if (!strcmp("-n", argv[i]))
+            maxSize = atoi(argv[i + 1]);
+        else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    cl_global_init_defaults("symbench", /* debug_level */ 0);
+    const FakeStorage fs;
+    Trace::NodeHandle trace(new Trace::TransientNode("symbench"));
+
+    printf("%-20s %-8s %6s %14s\n", "# operation", "shape", "size", "usec/op");
+    for (int shape = SHAPE_SLL; shape <= SHAPE_ARRAY; ++shape) {
+        for (int size = 2; size <= maxSize; size <<= 1) {
+            SymHeap sh(fs.stor(), trace.node());
+            buildShape(sh, fs, static_cast<EShape>(shape), size);
+            buildShape(sh, fs, SHAPE_SLL, size, VAR_AUX);
+
+            SymHeap shLonger(fs.stor(), trace.node());
+            buildShape(shLonger, fs, static_cast<EShape>(shape), size + 1);
+            buildShape(shLonger, fs, SHAPE_SLL, size + 1, VAR_AUX);
+
+            const BenchCtx ctx = {
+                fs, sh, shLonger, static_cast<EShape>(shape), size
+            };
+
+            BOOST_FOREACH(const BenchDesc &bench, benchList) {
+                if (!selected(bench.name, argc, argv, i))
+                    continue;
+
+                const double t = runBench(bench, ctx, minTime);
+                printf("%-20s %-8s %6d %14.2f\n", bench.name,
+                        shapeNames[shape], size, 1e6 * t);
+                fflush(stdout);
+            }
+        }
+    }
+
+    cl_global_cleanup();
+    return EXIT_SUCCESS;
+}
@@ -30,6 +30,7 @@
 #include "symdebug.hh"
 #include "symheap.hh"
 #include "symjoin.hh"
+#include "sympolicy.hh"
 #include "symproc.hh"
 #include "symstate.hh"
 #include "symutil.hh"
@@ -51,12 +52,12 @@ class PerFncCache {
 
         SymHeapUnion    huni_;
         TCtxMap         ctxMap_;
-#if !SE_ENABLE_CALL_CACHE
         SymCallCtx     *null_;
-#endif
         int             missCntSinceLastHit_;
 
         int lookupCore(const SymHeap &sh);
+        int lookupByJoin(const SymHeap &sh);
+        int lookupByIsomorphism(const SymHeap &sh);
 
         void cacheHit() {
             if (0 < missCntSinceLastHit_)
@@ -67,6 +68,7 @@ class PerFncCache {
 
     public:
         PerFncCache():
+            null_(0),
             missCntSinceLastHit_(0)
         {
         }
@@ -81,6 +83,28 @@ class PerFncCache {
             return missCntSinceLastHit_;
         }
 
+        /// count of call contexts cached for the function
+        int size() const {
+            return ctxMap_.size();
+        }
+
+        /// count of heaps held by the cache (entry heaps and cached results)
+        int cntHeaps() const;
+
+        /// index of the least recently used ctx not in use, -1 if there is none
+        int lruCandidate() const;
+
+        /// return the ctx at the given index
+        SymCallCtx* ctxAt(int idx) const {
+            return ctxMap_[idx];
+        }
+
+        /// last use of the ctx at the given index (valid only if idx >= 0)
+        unsigned long lastUsed(int idx) const;
+
+        /// remove the ctx at the given index from the cache and destroy it
+        void evict(int idx);
+
         bool inUse() const {
             BOOST_FOREACH(const SymCallCtx *ctx, ctxMap_)
                 if (ctx->inUse())
@@ -90,10 +114,11 @@ class PerFncCache {
         }
 
         void updateCacheEntry(const SymHeap &of, SymHeap by) {
-#if !SE_ENABLE_CALL_CACHE
-            CL_BREAK_IF("invalid call of PerFncCache::updateCacheEntry()");
-            return;
-#endif
+            if (!sePolicy().enableCallCache) {
+                CL_BREAK_IF("invalid call of PerFncCache::updateCacheEntry()");
+                return;
+            }
+
             const int idx = this->lookupCore(of);
             CL_BREAK_IF(!areEqual(of, huni_[idx]));
 
@@ -106,20 +131,34 @@ class PerFncCache {
          * 0 otherwise
          */
         SymCallCtx*& lookup(const SymHeap &sh) {
-#if SE_ENABLE_CALL_CACHE
-            return ctxMap_[this->lookupCore(sh)];
-#else
-            (void) sh;
-            return null_ = 0;
-#endif
+            if (sePolicy().enableCallCache)
+                return ctxMap_[this->lookupCore(sh)];
+            else
+                return null_ = 0;
         }
 };
 
 int PerFncCache::lookupCore(const SymHeap &sh) {
-#if 1 < SE_ENABLE_CALL_CACHE
-#if SE_STATE_ON_THE_FLY_ORDERING
-#error "SE_STATE_ON_THE_FLY_ORDERING is incompatible with join-based call cache"
-#endif
+    // the policy is resolved once per lookup, not per each cached heap
+    int idx = (1 < sePolicy().enableCallCache)
+        ? this->lookupByJoin(sh)
+        : this->lookupByIsomorphism(sh);
+
+    if (-1 != idx)
+        return idx;
+
+    // cache miss
+    idx = ctxMap_.size();
+    huni_.insertNew(sh);
+    ctxMap_.push_back((SymCallCtx *) 0);
+    CL_BREAK_IF(huni_.size() != ctxMap_.size());
+
+    ++missCntSinceLastHit_;
+    return idx;
+}
+
+int PerFncCache::lookupByJoin(const SymHeap &sh) {
+    // SymExecPolicy::set() does not allow this with SE_STATE_ON_THE_FLY_ORDERING
     EJoinStatus     status;
     SymHeap         result(sh.stor(), new Trace::TransientNode("PerFncCache"));
     const int       cnt = huni_.size();
@@ -168,27 +207,21 @@ int PerFncCache::lookupCore(const SymHeap &sh) {
         return idx;
     }
 
-#else // 1 == SE_ENABLE_CALL_CACHE means "graph isomorphism only"
-    int idx = huni_.lookup(sh);
-    if (-1 != idx) {
-        this->cacheHit();
-#   if 1 < SE_STATE_ON_THE_FLY_ORDERING
-        rotate(ctxMap_.begin(), ctxMap_.begin() + idx, ctxMap_.end());
-        return 0;
-#   else
-        return idx;
-#   endif
-    }
-#endif
+    return -1;
+}
 
-    // cache miss
-    idx = ctxMap_.size();
-    huni_.insertNew(sh);
-    ctxMap_.push_back((SymCallCtx *) 0);
-    CL_BREAK_IF(huni_.size() != ctxMap_.size());
+int PerFncCache::lookupByIsomorphism(const SymHeap &sh) {
+    const int idx = huni_.lookup(sh);
+    if (-1 == idx)
+        return -1;
 
-    ++missCntSinceLastHit_;
+    this->cacheHit();
+#if 1 < SE_STATE_ON_THE_FLY_ORDERING
+    rotate(ctxMap_.begin(), ctxMap_.begin() + idx, ctxMap_.end());
+    return 0;
+#else
     return idx;
+#endif
 }
 
 
@@ -203,13 +236,25 @@ struct SymCallCache::Private {
     TCache                      cache;
     TCtxStack                   ctxStack;
     SymBackTrace                bt;
+    unsigned long               lruClock;
+    int                         cntHits;
+    int                         cntMisses;
+    int                         cntEvictions;
 
     void importGlVar(SymHeap &sh, const CVar &cv);
     void resolveHeapCut(TCVarList &cut, SymHeap &sh, TFncRef &fnc);
     SymCallCtx* getCallCtx(const SymHeap &entry, TFncRef fnc);
+    void evictCtx(PerFncCache &pfc, int idx, const char *reason);
+    void enforceLimits(PerFncCache &pfc);
+    bool exceedsLimits() const;
+    bool dropCacheOnMisses(const CodeStorage::Fnc &fnc);
 
     Private(TStorRef stor, bool ptrace):
-        bt(stor, ptrace)
+        bt(stor, ptrace),
+        lruClock(0UL),
+        cntHits(0),
+        cntMisses(0),
+        cntEvictions(0)
     {
     }
 };
@@ -224,6 +269,7 @@ struct SymCallCtx::Private {
     const struct cl_operand     *dst;
     SymHeapUnion                rawResults;
     int                         nestLevel;
+    unsigned long               lastUsed;
     bool                        computed;
     bool                        flushed;
 
@@ -237,12 +283,60 @@ struct SymCallCtx::Private {
                 new Trace::TransientNode("SymCallCtx::Private::entry")),
         callFrame(cd_->bt.stor(),
                 new Trace::TransientNode("SymCallCtx::Private::callFrame")),
+        lastUsed(0UL),
         computed(false),
         flushed(false)
     {
     }
 };
 
+// /////////////////////////////////////////////////////////////////////////////
+// implementation of the eviction helpers of PerFncCache
+int PerFncCache::cntHeaps() const {
+    int cnt = 0;
+    BOOST_FOREACH(const SymCallCtx *ctx, ctxMap_) {
+        // count the entry heap
+        ++cnt;
+
+        if (ctx)
+            // count the cached results
+            cnt += ctx->d->rawResults.size();
+    }
+
+    return cnt;
+}
+
+int PerFncCache::lruCandidate() const {
+    int idxBest = -1;
+
+    const int cnt = ctxMap_.size();
+    for (int idx = 0; idx < cnt; ++idx) {
+        const SymCallCtx *ctx = ctxMap_[idx];
+        if (!ctx || ctx->inUse())
+            // we are not allowed to remove contexts used by the backtrace
+            continue;
+
+        if (-1 == idxBest || ctx->d->lastUsed < this->lastUsed(idxBest))
+            idxBest = idx;
+    }
+
+    return idxBest;
+}
+
+unsigned long PerFncCache::lastUsed(int idx) const {
+    return ctxMap_[idx]->d->lastUsed;
+}
+
+void PerFncCache::evict(int idx) {
+    SymCallCtx *ctx = ctxMap_[idx];
+    CL_BREAK_IF(!ctx || ctx->inUse());
+
+    delete ctx;
+    ctxMap_.erase(ctxMap_.begin() + idx);
+    huni_.eraseExisting(idx);
+    CL_BREAK_IF(huni_.size() != ctxMap_.size());
+}
+
 SymCallCtx::SymCallCtx(SymCallCache::Private *cd):
     d(new Private(cd))
 {
@@ -433,16 +527,21 @@ void SymCallCtx::flushCallResults(SymState &dst) {
         d->destroyStackFrame(sh);
         LDP_PLOT(symcall, sh);
 
-#if SE_ABSTRACT_ON_CALL_DONE
-        // after the final merge and cleanup, chances are that the abstraction
-        // may be useful
-        abstractIfNeeded(sh);
-        LDP_PLOT(symcall, sh);
-#endif
+        if (sePolicy().abstractOnCallDone) {
+            // after the final merge and cleanup, chances are that the
+            // abstraction may be useful
+            abstractIfNeeded(sh);
+            LDP_PLOT(symcall, sh);
+        }
+
         // flush the result
         dst.insert(sh);
     }
 
+    // the raw results are kept in the cache, the ctx is still in use here
+    const int uid = uidOf(*d->fnc);
+    d->cd->enforceLimits(d->cd->cache[uid]);
+
     // mark as done
     d->computed = true;
     d->flushed = true;
@@ -452,34 +551,19 @@ void SymCallCtx::flushCallResults(SymState &dst) {
 }
 
 void SymCallCtx::invalidate() {
-#if SE_ENABLE_CALL_CACHE
-#   if SE_CALL_CACHE_MISS_THR
-    typedef SymCallCache::Private::TCache TCache;
-    TCache &cache = d->cd->cache;
-    const CodeStorage::Fnc &fnc = *d->fnc;
-    const int uid = uidOf(fnc);
-    const TCache::iterator it = cache.find(uid);
-    CL_BREAK_IF(it == cache.end());
-
-    const PerFncCache &pfc = it->second;
-    const int missCnt = pfc.missCntSinceLastHit();
-    if (missCnt < (SE_CALL_CACHE_MISS_THR))
+    if (!sePolicy().enableCallCache) {
+        delete this;
         return;
+    }
 
-    const struct cl_loc *loc = locationOf(fnc);
-    CL_DEBUG_MSG(&loc, "SE_CALL_CACHE_MISS_THR reached for "
-            << nameOf(fnc) << "(): " << missCnt);
-
-    if (pfc.inUse()) {
-        CL_DEBUG_MSG(&loc, "... but PerFncCache is still being used!");
+    // the ctx may be destroyed by any of the calls below
+    SymCallCache::Private *cd = d->cd;
+    const CodeStorage::Fnc &fnc = *d->fnc;
+    if (cd->dropCacheOnMisses(fnc))
         return;
-    }
 
-    cache.erase(it);
-#   endif
-#else
-    delete this;
-#endif
+    // the ctx is no longer in use, so it may be evicted now, too
+    cd->enforceLimits(cd->cache[uidOf(fnc)]);
 }
 
 // /////////////////////////////////////////////////////////////////////////////
@@ -497,6 +581,21 @@ SymBackTrace& SymCallCache::bt() {
     return d->bt;
 }
 
+void SymCallCache::printStats() const {
+    int cntCtx = 0;
+    int cntHeaps = 0;
+    BOOST_FOREACH(Private::TCache::const_reference item, d->cache) {
+        const PerFncCache &pfc = item.second;
+        cntCtx += pfc.size();
+        cntHeaps += pfc.cntHeaps();
+    }
+
+    CL_NOTE("... SymCallCache holds " << cntCtx << " call context(s)"
+            ", " << cntHeaps << " heap(s) total"
+            ", " << d->cntEvictions << " context(s) evicted so far"
+            ", " << d->cntHits << " hit(s), " << d->cntMisses << " miss(es)");
+}
+
 void pullGlVar(SymHeap &result, SymHeap origin, const CVar &cv) {
     // do not try to combine things, it causes problems
     CL_BREAK_IF(!areEqual(result, SymHeap(origin.stor(), origin.traceNode())));
@@ -589,11 +688,15 @@ void SymCallCache::Private::resolveHeapCut(
 {
     const TFncVarSet &fncVars = fnc.vars;
     const int nestLevel = bt.countOccurrencesOfTopFnc();
-#if SE_ENABLE_CALL_CACHE
+    const bool callCache = sePolicy().enableCallCache;
     TStorRef stor = sh.stor();
 
     // start with all gl variables that are accessible from this function
     BOOST_FOREACH(const int uid, fncVars) {
+        if (!callCache)
+            // all gl vars are taken below
+            break;
+
         const CodeStorage::Var &var = stor.vars[uid];
         if (isOnStack(var))
             continue;
@@ -605,7 +708,6 @@ void SymCallCache::Private::resolveHeapCut(
 
         cut.push_back(cv);
     }
-#endif
 
     TValList live;
     sh.gatherRootObjects(live, isProgramVar);
@@ -614,9 +716,9 @@ void SymCallCache::Private::resolveHeapCut(
 
         const EValueTarget code = sh.valTarget(root);
         if (VT_STATIC == code) {
-#if !SE_ENABLE_CALL_CACHE
-            cut.push_back(cv);
-#endif
+            if (!callCache)
+                cut.push_back(cv);
+
             continue;
         }
 
@@ -691,20 +793,29 @@ void setCallArgs(
 }
 
 SymCallCtx* SymCallCache::Private::getCallCtx(const SymHeap &entry, TFncRef fnc) {
+    // the limits are enforced whenever the cache grows, not only on a miss
+    CL_BREAK_IF(this->exceedsLimits());
+
     // cache lookup
     const int uid = uidOf(fnc);
     PerFncCache &pfc = this->cache[uid];
     SymCallCtx *&ctx = pfc.lookup(entry);
     if (!ctx) {
         // cache miss
+        ++this->cntMisses;
         ctx = new SymCallCtx(this);
         ctx->d->fnc     = &fnc;
         ctx->d->entry   = entry;
+        ctx->d->lastUsed = ++this->lruClock;
         Trace::waiveCloneOperation(ctx->d->entry);
 
         // enter ctx stack
         this->ctxStack.push_back(ctx);
-        return ctx;
+
+        // the reference into PerFncCache is invalidated by eviction
+        SymCallCtx *ctxNew = ctx;
+        this->enforceLimits(pfc);
+        return ctxNew;
     }
 
     const struct cl_loc *loc = locationOf(fnc);
@@ -727,9 +838,121 @@ SymCallCtx* SymCallCache::Private::getCallCtx(const SymHeap &entry, TFncRef fnc)
     this->ctxStack.push_back(ctx);
 
     // all OK, return the cached ctx
+    ++this->cntHits;
+    ctx->d->lastUsed = ++this->lruClock;
     return ctx;
 }
 
+void SymCallCache::Private::evictCtx(
+        PerFncCache                     &pfc,
+        const int                       idx,
+        const char                      *reason)
+{
+    SymCallCtx *ctx = pfc.ctxAt(idx);
+    const CodeStorage::Fnc &fnc = *ctx->d->fnc;
+    CL_DEBUG_MSG(locationOf(fnc), "SymCallCache evicts a call context of "
+            << nameOf(fnc) << "() because " << reason
+            << " has been reached");
+
+    pfc.evict(idx);
+    ++this->cntEvictions;
+}
+
+void SymCallCache::Private::enforceLimits(PerFncCache &pfc) {
+    const int maxCtx = sePolicy().callCacheMaxCtxPerFnc;
+    while (maxCtx && maxCtx < pfc.size()) {
+        const int idx = pfc.lruCandidate();
+        if (-1 == idx)
+            // all contexts of the fnc are in use by the current backtrace
+            break;
+
+        this->evictCtx(pfc, idx, "call_cache_max_ctx_per_fnc");
+    }
+
+    const int maxHeaps = sePolicy().callCacheMaxHeaps;
+    if (!maxHeaps)
+        return;
+
+    int cntHeaps = 0;
+    BOOST_FOREACH(TCache::const_reference item, this->cache)
+        cntHeaps += item.second.cntHeaps();
+
+    while (maxHeaps < cntHeaps) {
+        // look for the least recently used ctx over all the cached fncs
+        PerFncCache *pfcBest = 0;
+        int idxBest = -1;
+        BOOST_FOREACH(TCache::reference item, this->cache) {
+            PerFncCache &pfcNow = item.second;
+            const int idx = pfcNow.lruCandidate();
+            if (-1 == idx)
+                continue;
+
+            if (pfcBest && pfcBest->lastUsed(idxBest) < pfcNow.lastUsed(idx))
+                continue;
+
+            pfcBest = &pfcNow;
+            idxBest = idx;
+        }
+
+        if (!pfcBest)
+            // all cached contexts are in use by the current backtrace
+            break;
+
+        cntHeaps -= 1 + pfcBest->ctxAt(idxBest)->rawResults().size();
+        this->evictCtx(*pfcBest, idxBest, "call_cache_max_heaps");
+    }
+}
+
+// true if a limit is exceeded although there is a ctx that could be evicted
+bool SymCallCache::Private::exceedsLimits() const {
+    const int maxCtx = sePolicy().callCacheMaxCtxPerFnc;
+    const int maxHeaps = sePolicy().callCacheMaxHeaps;
+    if (!maxCtx && !maxHeaps)
+        return false;
+
+    int cntHeaps = 0;
+    bool canEvict = false;
+    BOOST_FOREACH(TCache::const_reference item, this->cache) {
+        const PerFncCache &pfc = item.second;
+        const bool canEvictNow = (-1 != pfc.lruCandidate());
+        if (maxCtx && maxCtx < pfc.size() && canEvictNow)
+            return true;
+
+        cntHeaps += pfc.cntHeaps();
+        canEvict |= canEvictNow;
+    }
+
+    return maxHeaps && maxHeaps < cntHeaps && canEvict;
+}
+
+// return true if the cache of the fnc has been dropped (with all its ctxs)
+bool SymCallCache::Private::dropCacheOnMisses(const CodeStorage::Fnc &fnc) {
+#if SE_CALL_CACHE_MISS_THR
+    const TCache::iterator it = this->cache.find(uidOf(fnc));
+    CL_BREAK_IF(it == this->cache.end());
+
+    const PerFncCache &pfc = it->second;
+    const int missCnt = pfc.missCntSinceLastHit();
+    if (missCnt < (SE_CALL_CACHE_MISS_THR))
+        return false;
+
+    const struct cl_loc *loc = locationOf(fnc);
+    CL_DEBUG_MSG(&loc, "SE_CALL_CACHE_MISS_THR reached for "
+            << nameOf(fnc) << "(): " << missCnt);
+
+    if (pfc.inUse()) {
+        CL_DEBUG_MSG(&loc, "... but PerFncCache is still being used!");
+        return false;
+    }
+
+    this->cache.erase(it);
+    return true;
+#else
+    (void) fnc;
+    return false;
+#endif
+}
+
 SymCallCtx* SymCallCache::getCallCtx(
         SymHeap                         entry,
         const CodeStorage::Fnc          &fnc,
@@ -61,6 +61,9 @@ class SymCallCache {
                 const CodeStorage::Fnc       &fnc,
                 const CodeStorage::Insn      &insn);
 
+        /// print count of cached contexts/heaps, evictions, hits and misses
+        void printStats() const;
+
     private:
         /// object copying is @b not allowed
         SymCallCache(const SymCallCache &);
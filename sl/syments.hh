@@ -189,6 +189,15 @@ class EntStore {
         template <typename TId> inline const TBaseEnt* getEntRO(const TId id);
         template <typename TId> inline TBaseEnt* getEntRW(const TId id);
 
+        /// move each entity to idMap[id], entities are kept as they are
+        inline void renumber(const std::vector<int> &idMap);
+
+        /// make sure that IDs below cnt are never assigned by assignId(ptr)
+        void reserveIds(const unsigned cnt) {
+            if (ents_.size() < cnt)
+                ents_.resize(cnt, 0);
+        }
+
         template <class TEnt, typename TId>
         inline void getEntRO(const TEnt **, const TId id);
 
@@ -330,4 +339,29 @@ inline void EntStore<TBaseEnt>::getEntRW(TEnt **pEnt, const TId id) {
     *pEnt = ent;
 }
 
+template <class TBaseEnt>
+inline void EntStore<TBaseEnt>::renumber(const std::vector<int> &idMap) {
+    std::vector<TBaseEnt *> dst;
+    const unsigned cnt = ents_.size();
+    for (unsigned id = 0; id < cnt; ++id) {
+        TBaseEnt *ent = ents_[id];
+        if (!ent)
+            continue;
+
+        // if this fails, a valid entity has been omitted by the map
+        const int dstId = idMap[id];
+        CL_BREAK_IF(dstId < 0);
+
+        if (static_cast<int>(dst.size()) <= dstId)
+            dst.resize(dstId + 1, 0);
+
+        dst[dstId] = ent;
+    }
+
+    ents_.swap(dst);
+#if SH_REUSE_FREE_IDS
+    freeIds_ = std::queue<unsigned>();
+#endif
+}
+
 #endif /* H_GUARD_SYM_ENTS_H */
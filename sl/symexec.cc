@@ -32,15 +32,21 @@
 #include "symdebug.hh"
 #include "sympath.hh"
 #include "symproc.hh"
+#include "symreach.hh"
+#include "symseg.hh"
 #include "symstate.hh"
 #include "symutil.hh"
 #include "symtrace.hh"
 #include "util.hh"
 
+#include <ctime>
+#include <map>
 #include <queue>
 #include <set>
 #include <sstream>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
 #include <boost/foreach.hpp>
 
@@ -53,6 +59,72 @@ bool installSignalHandlers(void) {
         && SignalCatcher::install(SIGTERM);
 }
 
+// /////////////////////////////////////////////////////////////////////////////
+// time budgets
+struct TimeBudgetExceeded { };
+
+float secondsSince(const clock_t since) {
+    static const float RATIO = CLOCKS_PER_SEC;
+    return (clock() - since) / RATIO;
+}
+
+/// havoc data of an abstract object, its binding pointers are kept in place
+void havocSegData(SymHeap &sh, const TValId seg, const TSizeOf size) {
+    const EObjKind kind = sh.valTargetKind(seg);
+    const bool hasNext = (OK_OBJ_OR_NULL != kind);
+    const bool hasPrev = (OK_DLS == kind);
+
+    TValId valNext = VAL_INVALID;
+    if (hasNext)
+        valNext = nextPtrFromSeg(sh, seg).value();
+
+    TValId valPrev = VAL_INVALID;
+    if (hasPrev)
+        valPrev = prevPtrFromSeg(sh, seg).value();
+
+    const TValId tplValue = sh.valCreate(VT_UNKNOWN, VO_UNKNOWN);
+    sh.writeUniformBlock(seg, tplValue, size);
+
+    if (hasNext)
+        nextPtrFromSeg(sh, seg).setValue(valNext);
+    if (hasPrev)
+        prevPtrFromSeg(sh, seg).setValue(valPrev);
+
+    // the callee could have removed any of the concrete objects it abstracts
+    sh.segSetMinLength(seg, /* may be empty */ 0);
+}
+
+/**
+ * replace contents of the objects a callee could have written by unknown values
+ * @note The shape of list segments is kept, so the callee is assumed not to
+ * relink them.  Objects freed by the callee are not modelled either, they are
+ * still treated as allocated on return from the call.
+ */
+void havocReachableData(SymHeap &sh) {
+    // the heap is already cut by symcut, so that all the remaining objects are
+    // reachable from the call arguments and the gl variables used by the callee
+    TValList roots;
+    sh.gatherRootObjects(roots, isPossibleToDeref);
+    BOOST_FOREACH(const TValId root, roots) {
+        const EValueTarget code = sh.valTarget(root);
+        if (VT_ON_STACK == code && !sh.pointedByCount(root))
+            // a local variable the callee cannot access without its address
+            continue;
+
+        const TSizeOf size = sh.valSizeOfTarget(root).lo;
+        if (size <= 0)
+            continue;
+
+        if (VT_ABSTRACT == code) {
+            havocSegData(sh, root, size);
+            continue;
+        }
+
+        const TValId tplValue = sh.valCreate(VT_UNKNOWN, VO_UNKNOWN);
+        sh.writeUniformBlock(root, tplValue, size);
+    }
+}
+
 // /////////////////////////////////////////////////////////////////////////////
 // ExecStack
 class SymExecEngine;
@@ -95,10 +167,13 @@ class SymExec: public IStatsProvider {
         virtual void printStats() const;
 
     private:
+        typedef std::map<int /* uid */, float /* sec */> TFncTimeMap;
+
         const CodeStorage::Storage              &stor_;
         SymExecParams                           params_;
         SymCallCache                            callCache_;
         TExecStack                              execStack_;
+        TFncTimeMap                             fncTime_;
 };
 
 // /////////////////////////////////////////////////////////////////////////////
@@ -110,12 +185,15 @@ class SymExecEngine: public IStatsProvider {
                 const SymHeap           &entry,
                 const IStatsProvider    &stats,
                 const SymExecParams     &ep,
-                SymBackTrace            &bt):
+                SymBackTrace            &bt,
+                float                   &fncTime):
             stor_(entry.stor()),
             params_(ep),
             bt_(bt),
             dst_(results),
             stats_(stats),
+            fncTime_(fncTime),
+            callTime_(0.0),
             ptracer_(stateMap_),
             sched_(stateMap_),
             block_(0),
@@ -136,8 +214,12 @@ class SymExecEngine: public IStatsProvider {
         }
 
     public:
+        /// @throw TimeBudgetExceeded if a time budget given by params is over
         bool /* complete */ run();
 
+        /// use an over-approximation of the call results if we failed in time
+        void overApproximate(const SymHeap &entry);
+
         virtual void printStats() const;
 
         // TODO: describe the interface briefly
@@ -154,6 +236,9 @@ class SymExecEngine: public IStatsProvider {
         SymState                        &dst_;
         const IStatsProvider            &stats_;
         std::string                     fncName_;
+        float                           &fncTime_;
+        float                           callTime_;
+        clock_t                         resumedAt_;
 
         SymStateMap                     stateMap_;
         PathTracer                      ptracer_;
@@ -167,6 +252,7 @@ class SymExecEngine: public IStatsProvider {
         SymHeapList                     localState_;
         SymHeapList                     nextLocalState_;
         SymHeapList                     callResults_;
+        std::vector<SymHeapList>        segmentBufs_;
         const struct cl_loc             *lw_;
 
     private:
@@ -174,10 +260,15 @@ class SymExecEngine: public IStatsProvider {
 
         void joinCallResults();
 
+        /**
+         * @attention the given heap is moved into the state of ofBlock, or
+         * dropped if the error label cannot be reached from ofBlock
+         */
         void updateState(SymHeap &sh, const CodeStorage::Block *ofBlock);
 
+        /// @attention the given heap may be moved away or changed
         void updateStateInBranch(
-                SymHeap                             sh,
+                SymHeap                             &sh,
                 const bool                          branch,
                 const CodeStorage::Insn             &insnCmp,
                 const CodeStorage::Insn             &insnCnd,
@@ -195,10 +286,20 @@ class SymExecEngine: public IStatsProvider {
         void execReturn();
         void execCondInsn();
         void execTermInsn();
+        bool execCoreInsn(
+                SymState                            &dst,
+                SymHeap                             &sh,
+                const CodeStorage::Insn             &insn);
+
         bool execNontermInsn();
         bool execInsn();
+        unsigned segmentEnd() const;
+        void execSegmentHeap(SymHeap &sh, unsigned idx, unsigned end);
+        void execSegment(unsigned end);
         bool execBlock();
+        bool runCore();
         void processPendingSignals();
+        void chkTimeBudget();
         void pruneOrigin();
 
         void dumpStateMap();
@@ -234,10 +335,8 @@ void SymExecEngine::execJump() {
     const CodeStorage::Insn *insn = block_->operator[](insnIdx_);
     const CodeStorage::TTargetList &tlist = insn->targets;
 
-    // make a copy in case we needed to perform an abstraction
-    const SymHeap &origin = localState_[heapIdx_];
-    SymHeap sh(origin);
-    Trace::waiveCloneOperation(sh);
+    // the heap is not needed in localState_ any more, no need to copy it
+    SymHeap sh(std::move(localState_[heapIdx_]));
 
     this->updateState(sh, tlist[/* target */ 0]);
 }
@@ -247,11 +346,10 @@ void SymExecEngine::execReturn() {
     const CodeStorage::TOperandList &opList = insn->operands;
     CL_BREAK_IF(1 != opList.size());
 
-    // create a local copy of the heap
-    const SymHeap &origin = localState_[heapIdx_];
-    SymHeap sh(origin);
+    // the heap is not needed in localState_ any more, no need to copy it
+    SymHeap sh(std::move(localState_[heapIdx_]));
 
-    Trace::Node *trOrig = origin.traceNode();
+    Trace::Node *trOrig = sh.traceNode();
     Trace::Node *trRet = new Trace::InsnNode(trOrig, insn, /* bin */ false);
     sh.traceUpdate(trRet);
 
@@ -269,7 +367,7 @@ void SymExecEngine::execReturn() {
     }
 
     // commit one of the function results
-    dst_.insert(sh);
+    dst_.insert(std::move(sh));
     endReached_ = true;
 }
 
@@ -288,6 +386,16 @@ void SymExecEngine::updateState(SymHeap &sh, const CodeStorage::Block *ofBlock)
 {
     const std::string &name = ofBlock->name();
 
+    const ErrLabelReach *reach = params_.errLabelReach;
+    if (reach && !reach->canReach(ofBlock)) {
+        CL_DEBUG_MSG(lw_, "<P> dropping a heap entering block " << name
+                << ", the error label cannot be reached from there");
+
+        // the paths are cut on purpose, do not complain about the end of fnc
+        endReached_ = true;
+        return;
+    }
+
     bool closingLoop = isLoopClosingEdge(/* term */ block_->back(), ofBlock);
     if (closingLoop)
         CL_DEBUG_MSG(lw_, "-L- traversing a loop-closing edge");
@@ -298,12 +406,11 @@ void SymExecEngine::updateState(SymHeap &sh, const CodeStorage::Block *ofBlock)
 #endif
         abstractIfNeeded(sh);
 
-#if !SE_JOIN_ON_LOOP_EDGES_ONLY
-    closingLoop = true;
-#endif
+    if (!sePolicy().joinOnLoopEdgesOnly)
+        closingLoop = true;
 
     // update _target_ state and check if anything has changed
-    if (stateMap_.insert(ofBlock, block_, sh, closingLoop)) {
+    if (stateMap_.insert(ofBlock, block_, std::move(sh), closingLoop)) {
         const SymStateMarked &target = stateMap_[ofBlock];
 
         // schedule for next wheel (if not already)
@@ -324,7 +431,7 @@ bool isAnyAbstractOf(const SymHeapCore &sh, const TValId v1, const TValId v2) {
 }
 
 void SymExecEngine::updateStateInBranch(
-        SymHeap                     shOrig,
+        SymHeap                     &shOrig,
         const bool                  branch,
         const CodeStorage::Insn    &insnCmp,
         const CodeStorage::Insn    &insnCnd,
@@ -336,7 +443,6 @@ void SymExecEngine::updateStateInBranch(
     procOrig.setLocation(lw_);
 
     // prepare trace node for a non-deterministic condition
-    Trace::waiveCloneOperation(shOrig);
     Trace::Node *trCond = new Trace::CondNode(shOrig.traceNode(),
                 &insnCmp, &insnCnd, /* det */ false, branch);
 
@@ -413,8 +519,9 @@ skip_tracking:
     proc1.killPerTarget(insnCnd, /* then label */ 0);
     this->updateState(sh1, insnCnd.targets[/* then label */ 0]);
 
-    SymHeap sh2(sh);
-    sh2.traceUpdate(new Trace::CondNode(sh.traceNode(),
+    // the last use of sh, no need to copy it
+    SymHeap sh2(std::move(sh));
+    sh2.traceUpdate(new Trace::CondNode(sh2.traceNode(),
                 &insnCmp, &insnCnd, /* det */ false, /* branch */ false));
 
     CL_DEBUG_MSG(lw_, "-F- CL_INSN_COND updates FALSE branch");
@@ -446,9 +553,8 @@ void SymExecEngine::execCondInsn() {
     const struct cl_operand &op2 = insnCmp->operands[/* src2 */ 2];
     CL_BREAK_IF(!areComparableTypes(op1.type, op2.type));
 
-    // a working area in case of VAL_TRUE and VAL_FALSE
-    SymHeap sh(localState_[heapIdx_]);
-    Trace::waiveCloneOperation(sh);
+    // a working area, the heap is not needed in localState_ any more
+    SymHeap sh(std::move(localState_[heapIdx_]));
     SymProc proc(sh, &bt_);
     proc.setLocation(lw_);
 
@@ -513,7 +619,9 @@ void SymExecEngine::execCondInsn() {
     }
 
     CL_DEBUG_MSG(lw_, "?T? CL_INSN_COND updates TRUE branch");
-    this->updateStateInBranch(sh, true,  *insnCmp, *insnCnd, v1, v2);
+    SymHeap shThen(sh);
+    Trace::waiveCloneOperation(shThen);
+    this->updateStateInBranch(shThen, true,  *insnCmp, *insnCnd, v1, v2);
 
     CL_DEBUG_MSG(lw_, "?F? CL_INSN_COND updates FALSE branch");
     this->updateStateInBranch(sh, false, *insnCmp, *insnCnd, v1, v2);
@@ -546,9 +654,11 @@ void SymExecEngine::execTermInsn() {
     }
 }
 
-bool /* handled */ SymExecEngine::execNontermInsn() {
-    const CodeStorage::Insn *insn = block_->operator[](insnIdx_);
-
+bool /* handled */ SymExecEngine::execCoreInsn(
+        SymState                            &dst,
+        SymHeap                             &sh,
+        const CodeStorage::Insn             &insn)
+{
     // set some properties of the execution
     SymExecCoreParams ep;
     ep.trackUninit      = params_.trackUninit;
@@ -556,18 +666,12 @@ bool /* handled */ SymExecEngine::execNontermInsn() {
     ep.skipPlot         = params_.skipPlot;
     ep.errLabel         = params_.errLabel;
 
-    // working area for non-terminal instructions
-    const SymHeap &origin = localState_[heapIdx_];
-    SymHeap sh(origin);
     SymExecCore core(sh, &bt_, ep);
     core.setLocation(lw_);
 
-    // drop the unnecessary Trace::CloneNode node in the trace graph
-    Trace::waiveCloneOperation(sh);
-
     // execute the instruction
-    if (!core.exec(nextLocalState_, *insn)) {
-        CL_BREAK_IF(CL_INSN_CALL != insn->code);
+    if (!core.exec(dst, insn)) {
+        CL_BREAK_IF(CL_INSN_CALL != insn.code);
         return false;
     }
 
@@ -579,6 +683,130 @@ bool /* handled */ SymExecEngine::execNontermInsn() {
     return /* insn handled */ true;
 }
 
+bool /* handled */ SymExecEngine::execNontermInsn() {
+    const CodeStorage::Insn *insn = block_->operator[](insnIdx_);
+
+    // working area for non-terminal instructions, the entry heap of a call
+    // is still needed by callEntry(), other heaps can be moved away
+    SymHeap &origin = localState_[heapIdx_];
+    const bool isCall = (CL_INSN_CALL == insn->code);
+    SymHeap sh((isCall) ? SymHeap(origin) : std::move(origin));
+
+    if (isCall)
+        // drop the unnecessary Trace::CloneNode node in the trace graph
+        Trace::waiveCloneOperation(sh);
+
+    return this->execCoreInsn(nextLocalState_, sh, *insn);
+}
+
+/// end of the straight-line segment starting at insnIdx_, 0 if not worth it
+unsigned SymExecEngine::segmentEnd() const {
+    if (!sePolicy().fusedBlockSegments || heapIdx_)
+        // disabled, or resuming a suspended insn
+        return 0;
+
+    // the last insn of a block is always a terminal one
+    const unsigned last = block_->size() - 1;
+
+    unsigned idx = insnIdx_;
+    for (; idx < last; ++idx) {
+        const CodeStorage::Insn *insn = block_->operator[](idx);
+        if (CL_INSN_CALL == insn->code || cl_is_term_insn(insn->code))
+            break;
+
+        const CodeStorage::Insn *nextInsn = block_->operator[](idx + 1);
+        if (CL_INSN_COND == nextInsn->code)
+            // this one is going to be handled in execCondInsn()
+            break;
+    }
+
+    // a segment of a single insn gains nothing
+    return (insnIdx_ + 1 < idx)
+        ? idx
+        : 0;
+}
+
+/// run the heap through insns [idx, end) of block_, depth-first
+void SymExecEngine::execSegmentHeap(SymHeap &sh, unsigned idx, unsigned end) {
+    insnIdx_ = idx;
+
+    // time to respond to a single pending signal, also for intermediate heaps
+    this->processPendingSignals();
+    this->chkTimeBudget();
+
+    const CodeStorage::Insn *insn = block_->operator[](idx);
+    if (0 < insn->loc.line)
+        lw_ = &insn->loc;
+
+    if (end == idx + 1) {
+        // the last insn of the segment, materialize the results
+        this->execCoreInsn(nextLocalState_, sh, *insn);
+        return;
+    }
+
+    // the buffer is free as long as we go through its results one by one
+    SymHeapList &dst = segmentBufs_[idx];
+    CL_BREAK_IF(dst.size());
+    this->execCoreInsn(dst, sh, *insn);
+
+    for (unsigned i = 0; i < dst.size(); ++i)
+        this->execSegmentHeap(dst[i], idx + 1, end);
+
+    dst.clear();
+}
+
+/// execute insns [insnIdx_, end) heap by heap, the results go to nextLocalState_
+void SymExecEngine::execSegment(const unsigned end) {
+    const unsigned first = insnIdx_;
+    CL_DEBUG_MSG(lw_, "!!! executing insns #" << first
+            << " .. #" << (end - 1) << " heap by heap");
+
+    // let's begin with empty resulting heap union
+    nextLocalState_.clear();
+
+    // dispose the leftovers of a run interrupted by an exception
+    BOOST_FOREACH(SymHeapList &buf, segmentBufs_)
+        buf.clear();
+
+    if (segmentBufs_.size() < end)
+        segmentBufs_.resize(end);
+
+    // used only if (0 == first)
+    SymStateMarked &origin = stateMap_[block_];
+
+    const unsigned hCnt = localState_.size();
+    for (heapIdx_ = 0; heapIdx_ < hCnt; ++heapIdx_) {
+        if (!first) {
+            if (origin.isDone(heapIdx_))
+                // the result is already included in the resulting state
+                continue;
+
+            // mark as processed now since it can be re-scheduled right away
+            origin.setDone(heapIdx_);
+        }
+
+        if (1 < hCnt) {
+            CL_DEBUG_MSG(lw_, "*** processing block " << block_->name()
+                         << ", heap #" << heapIdx_
+                         << " (initial size of state was " << hCnt << ")");
+        }
+
+        // the first insn of the segment updates the heap in place
+        this->execSegmentHeap(localState_[heapIdx_], first, end);
+    }
+
+    // the location info as if we executed the segment insn by insn
+    for (unsigned idx = first; idx < end; ++idx) {
+        const CodeStorage::Insn *insn = block_->operator[](idx);
+        if (0 < insn->loc.line)
+            lw_ = &insn->loc;
+    }
+
+    // completed execution of the whole segment
+    insnIdx_ = end - 1;
+    heapIdx_ = 0;
+}
+
 bool /* complete */ SymExecEngine::execInsn() {
     const CodeStorage::Insn *insn = block_->operator[](insnIdx_);
 
@@ -634,6 +862,7 @@ bool /* complete */ SymExecEngine::execInsn() {
 
         // time to respond to a single pending signal
         this->processPendingSignals();
+        this->chkTimeBudget();
 
         if (isTerm) {
             // terminal insn
@@ -688,14 +917,21 @@ bool /* complete */ SymExecEngine::execBlock() {
             // update location info
             lw_ = &insn->loc;
 
+        const bool isEntry = !insnIdx_;
+
+        const unsigned end = this->segmentEnd();
+        if (end)
+            // execute a straight-line segment of insns, heap by heap
+            this->execSegment(end);
+
         // execute current instruction
-        if (!this->execInsn()) {
+        else if (!this->execInsn()) {
             // function call reached, we should stand by
             callResults_.clear();
             return false;
         }
 
-        if (!insnIdx_)
+        if (isEntry)
             this->pruneOrigin();
 
         if (!nextLocalState_.size())
@@ -711,15 +947,19 @@ bool /* complete */ SymExecEngine::execBlock() {
                  << "(), " << sched_.cntWaiting()
                  << " basic block(s) in the queue");
     insnIdx_ = 0;
+
+    // the block may not be scheduled again for a long time
+    stateMap_.coolDown(block_);
     return true;
 }
 
 void SymExecEngine::joinCallResults() {
-#if SE_ABSTRACT_ON_CALL_DONE
-    SymStateWithJoin all;
-#else
-    SymHeapUnion all;
-#endif
+    SymStateWithJoin allWithJoin;
+    SymHeapUnion allUnion;
+    SymState &all = (sePolicy().abstractOnCallDone)
+        ? static_cast<SymState &>(allWithJoin)
+        : static_cast<SymState &>(allUnion);
+
     all.swap(nextLocalState_);
 
     const unsigned cnt = callResults_.size();
@@ -732,14 +972,58 @@ void SymExecEngine::joinCallResults() {
 
         // time to respond to a single pending signal
         this->processPendingSignals();
+        this->chkTimeBudget();
 
-        all.insert(callResults_[i]);
+        all.insert(std::move(callResults_[i]));
     }
 
     all.swap(nextLocalState_);
 }
 
 bool /* complete */ SymExecEngine::run() {
+    resumedAt_ = clock();
+
+    // account the time spent at this call level, even if we run out of it
+    try {
+        const bool done = this->runCore();
+        const float spent = secondsSince(resumedAt_);
+        callTime_ += spent;
+        fncTime_ += spent;
+        return done;
+    }
+    catch (...) {
+        const float spent = secondsSince(resumedAt_);
+        callTime_ += spent;
+        fncTime_ += spent;
+        throw;
+    }
+}
+
+void SymExecEngine::overApproximate(const SymHeap &entry) {
+    SymHeap sh(entry);
+    Trace::waiveCloneOperation(sh);
+
+    CL_WARN_MSG(lw_, "time budget exceeded while executing " << fncName_
+            << "(), " << callTime_ << " s spent in this call context, "
+            << fncTime_ << " s in the function");
+
+    CL_NOTE_MSG(lw_, "results of the call are over-approximated, "
+            << dst_.size() << " result(s) already computed are kept");
+
+    SymProc proc(sh, &bt_);
+    proc.setLocation(lw_);
+    proc.printBackTrace(ML_WARN);
+
+    // whatever the callee could do with the memory it can reach is now unknown
+    havocReachableData(sh);
+    dst_.insert(sh);
+
+    // do not complain about the end of function not being reached
+    endReached_ = true;
+    waiting_ = false;
+}
+
+bool /* complete */ SymExecEngine::runCore() {
     const CodeStorage::Fnc fnc = *bt_.topFnc();
 
     if (waiting_) {
@@ -907,10 +1191,24 @@ void SymExecEngine::processPendingSignals() {
     }
 }
 
+void SymExecEngine::chkTimeBudget() {
+    const float callBudget = params_.callTimeBudget;
+    const float fncBudget = params_.fncTimeBudget;
+    if (callBudget <= 0.0 && fncBudget <= 0.0)
+        // unlimited
+        return;
+
+    const float spent = secondsSince(resumedAt_);
+    if (0.0 < callBudget && callBudget < callTime_ + spent)
+        throw TimeBudgetExceeded();
+
+    if (0.0 < fncBudget && fncBudget < fncTime_ + spent)
+        throw TimeBudgetExceeded();
+}
+
 void SymExecEngine::pruneOrigin() {
-#if SE_STATE_PRUNING_MODE
-    if (block_->isLoopEntry())
-#endif
+    const int mode = sePolicy().statePruningMode;
+    if (!mode || block_->isLoopEntry())
         // never prune loop entry, it would break the fixed-point computation
         return;
 
@@ -928,17 +1226,13 @@ void SymExecEngine::pruneOrigin() {
         goto thr_reached;
 #endif
 
-#if SE_STATE_PRUNING_MODE < 2
-    if (!cl_is_term_insn(block_->front()->code)
+    if (mode < 2 && !cl_is_term_insn(block_->front()->code)
             && (CL_INSN_COND != block_->back()->code || 2 < block_->size()))
         return;
-#endif
 
-#if SE_STATE_PRUNING_MODE < 3
-    if (1 < block_->inbound().size())
+    if (mode < 3 && 1 < block_->inbound().size())
         // more than one incoming edges, keep this one
         return;
-#endif
 
 #if SE_STATE_PRUNING_MISS_THR || SE_STATE_PRUNING_TOTAL_THR
 thr_reached:
@@ -1055,13 +1349,18 @@ fail:
 }
 
 void SymExec::enterCall(SymCallCtx *ctx, SymState &results) {
+    // time spent in the function so far (the callee is already on backtrace)
+    SymBackTrace &bt = callCache_.bt();
+    float &fncTime = fncTime_[uidOf(*bt.topFnc())];
+
     // create engine
     SymExecEngine *eng = new SymExecEngine(
             ctx->rawResults(),
             ctx->entry(),
             /* IStatsProvider */ *this,
             params_,
-            callCache_.bt());
+            bt,
+            fncTime);
 
     // initialize a stack item
     ExecStackItem item;
@@ -1093,7 +1392,17 @@ void SymExec::execFnc(
         SymExecEngine *engine = item.eng;
 
         // do as much as we can at the current call level
-        if (engine->run()) {
+        bool done;
+        try {
+            done = engine->run();
+        }
+        catch (const TimeBudgetExceeded &) {
+            // give up this call and continue with the caller
+            engine->overApproximate(item.ctx->entry());
+            done = true;
+        }
+
+        if (done) {
             printMemUsage("SymExecEngine::run");
 
             // call done at this level
@@ -1155,7 +1464,8 @@ void SymExec::execFnc(
 }
 
 void SymExec::printStats() const {
-    // TODO: print SymCallCache stats here as soon as we have implemented some
+    callCache_.printStats();
+    printHeapCopyStats();
 
     BOOST_FOREACH(const ExecStackItem &item, execStack_) {
         const IStatsProvider *provider = item.eng;
@@ -1176,6 +1486,10 @@ void execTopCall(
     try {
         SymExec se(entry.stor(), ep);
         se.execFnc(results, entry, insn, fnc);
+
+        // print the final statistics (collected by the benchmark driver)
+        se.printStats();
+
         // SymExec::~SymExec() is going to be executed as leaving this block
     }
     catch (const std::runtime_error &e) {
@@ -1194,6 +1508,9 @@ void execute(
     if (!installSignalHandlers())
         CL_WARN("unable to install signal handlers");
 
+    // policies selected at run-time
+    setSePolicy(ep.policy);
+
     // XXX: synthesize CL_INSN_CALL
     static CodeStorage::Insn insn;
     insn.stor = fnc.stor;
@@ -20,6 +20,9 @@
 #ifndef H_GUARD_SYM_EXEC_H
 #define H_GUARD_SYM_EXEC_H
 
+#include "config.h"
+#include "sympolicy.hh"
+
 #include <string>
 
 /**
@@ -27,6 +30,7 @@
  * SymExec - top level algorithm of the @b symbolic @b execution
  */
 
+class ErrLabelReach;
 class SymHeap;
 class SymState;
 
@@ -41,12 +45,23 @@ struct SymExecParams {
     bool skipPlot;          ///< simply ignore all ___sl_plot* calls
     bool ptrace;            ///< enable path tracing (a bit chatty)
     std::string errLabel;   ///< if not empty, treat reaching the label as error
+    bool errLabelOnly;      ///< care only about reachability of errLabel
+    const ErrLabelReach *errLabelReach; ///< if not null, used to prune paths
+    float fncTimeBudget;    ///< CPU time budget per function (0 = unlimited)
+    float callTimeBudget;   ///< CPU time budget per call context (0 = unlimited)
+    SymExecPolicy policy;   ///< trade-offs selected at run-time
+    unsigned portfolio;     ///< count of configurations to race (0 = off)
 
     SymExecParams():
         trackUninit(false),
         oomSimulation(false),
         skipPlot(false),
-        ptrace(false)
+        ptrace(false),
+        errLabelOnly(false),
+        errLabelReach(0),
+        fncTimeBudget(SE_FNC_TIME_BUDGET),
+        callTimeBudget(SE_CALL_TIME_BUDGET),
+        portfolio(0)
     {
     }
 };
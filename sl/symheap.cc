@@ -26,6 +26,8 @@
 #include <cl/storage.hh>
 
 #include "intarena.hh"
+#include "packbuf.hh"
+#include "persistmap.hh"
 #include "prototype.hh"
 #include "symabstract.hh"
 #include "syments.hh"
@@ -42,30 +44,88 @@
 #endif
 
 #include <algorithm>
+#include <deque>
 #include <map>
 #include <set>
+#include <utility>
 
 #include <boost/foreach.hpp>
 #include <boost/tuple/tuple.hpp>
 
-template <class TCont> typename TCont::value_type::second_type&
-assignInvalidIfNotFound(
-        TCont                                           &cont,
-        const typename TCont::value_type::first_type    &item)
-{
-    if (!hasKey(cont, item))
-        // -1 means "invalid", e.g. VAL_INVALID in case [T = map<???, TValId>]
-        cont[item] = static_cast<typename TCont::value_type::second_type>(-1);
-
-    return cont[item];
-}
-
 static bool bypassSelfChecks;
 
 void enableProtectedMode(bool enable) {
     ::bypassSelfChecks = !enable;
 }
 
+static HeapCopyStats copyStats;
+
+HeapCopyStats& heapCopyStats() {
+    return ::copyStats;
+}
+
+void printHeapCopyStats() {
+    const HeapCopyStats &st = ::copyStats;
+    CL_DEBUG("... SymHeap objects copied " << st.cntCopied << " time(s)"
+            ", " << st.cntMoved << " copies avoided by move");
+}
+
+// /////////////////////////////////////////////////////////////////////////////
+// order-preserving map of IDs used by SymHeapCore::compactIds()
+class IdMapper {
+    private:
+        std::vector<int>        idMap_;
+        unsigned                cntLive_;
+
+    public:
+        template <class TStore>
+        IdMapper(const TStore &ents):
+            cntLive_(0)
+        {
+            const int last = ents.template lastId<int>();
+            idMap_.resize(last + 1, /* released */ -1);
+            for (int id = 0; id <= last; ++id)
+                if (ents.isValidEnt(id))
+                    idMap_[id] = cntLive_++;
+        }
+
+        /// count of IDs still in use
+        unsigned cntLive() const {
+            return cntLive_;
+        }
+
+        /// the new ID of each entity, -1 for IDs no longer in use
+        const std::vector<int>& idMap() const {
+            return idMap_;
+        }
+
+        /// special (negative) IDs are kept, released IDs map to -1 (invalid)
+        template <typename TId>
+        TId operator()(const TId id) const {
+            if (id < 0)
+                return id;
+
+            CL_BREAK_IF(static_cast<int>(idMap_.size()) <= id);
+            return static_cast<TId>(idMap_[id]);
+        }
+
+        /// rebuild an ordered set of IDs, released IDs are dropped
+        template <class TSet>
+        void renumberSet(TSet &set) const {
+            TSet dst;
+            BOOST_FOREACH(const typename TSet::value_type id, set) {
+                const typename TSet::value_type dstId = (*this)(id);
+                if (0 <= id && dstId < 0)
+                    // stale reference to an already released entity
+                    continue;
+
+                dst.insert(dst.end(), dstId);
+            }
+
+            set.swap(dst);
+        }
+};
+
 // /////////////////////////////////////////////////////////////////////////////
 // Neq predicates store
 class NeqDb: public SymPairSet<TValId, /* IREFLEXIVE */ true> {
@@ -84,6 +144,30 @@ class NeqDb: public SymPairSet<TValId, /* IREFLEXIVE */ true> {
             }
         }
 
+        void renumber(const IdMapper &idMap) {
+            TCont dst;
+            BOOST_FOREACH(const TItem &item, cont_)
+                dst.insertOnce(TItem(idMap(item.first), idMap(item.second)));
+
+            cont_.swap(dst);
+        }
+
+        void pack(PackWriter &dst) const {
+            dst.putUInt(cont_.size());
+            BOOST_FOREACH(const TItem &item, cont_) {
+                dst.putInt(item.first);
+                dst.putInt(item.second);
+            }
+        }
+
+        void unpack(PackReader &src) {
+            for (unsigned long cnt = src.getUInt(); cnt; --cnt) {
+                const TValId v1 = static_cast<TValId>(src.getInt());
+                const TValId v2 = static_cast<TValId>(src.getInt());
+                cont_.insertOnce(TItem(v1, v2));
+            }
+        }
+
         friend void SymHeapCore::copyRelevantPreds(
                 SymHeapCore             &dst,
                 const TValMap           &vMap)
@@ -113,6 +197,35 @@ class CoincidenceDb: public SymPairMap</* v1, v2 */ TValId, TValId /* sum */> {
                     dst.push_back(item.first);
             }
         }
+
+        void renumber(const IdMapper &idMap) {
+            TMap dst;
+            BOOST_FOREACH(TMap::const_reference ref, db_) {
+                const TItem &item = ref.first;
+                const TItem key(idMap(item.first), idMap(item.second));
+                dst.set(key, idMap(ref.second));
+            }
+
+            db_.swap(dst);
+        }
+
+        void pack(PackWriter &dst) const {
+            dst.putUInt(db_.size());
+            BOOST_FOREACH(TMap::const_reference ref, db_) {
+                dst.putInt(ref.first.first);
+                dst.putInt(ref.first.second);
+                dst.putInt(ref.second);
+            }
+        }
+
+        void unpack(PackReader &src) {
+            for (unsigned long cnt = src.getUInt(); cnt; --cnt) {
+                const TValId v1 = static_cast<TValId>(src.getInt());
+                const TValId v2 = static_cast<TValId>(src.getInt());
+                const TValId sum = static_cast<TValId>(src.getInt());
+                db_.set(TItem(v1, v2), sum);
+            }
+        }
 };
 
 // /////////////////////////////////////////////////////////////////////////////
@@ -122,7 +235,7 @@ class CVarMap {
         RefCounter refCnt;
 
     private:
-        typedef std::map<CVar, TValId>              TCont;
+        typedef PersistentMap<CVar, TValId>         TCont;
         TCont                                       cont_;
 
     public:
@@ -131,7 +244,7 @@ class CVarMap {
             CL_BREAK_IF(hasKey(cont_, cVar));
 
             // define mapping
-            cont_[cVar] = val;
+            cont_.set(cVar, val);
         }
 
         void remove(CVar cVar) {
@@ -139,72 +252,102 @@ class CVarMap {
                 CL_BREAK_IF("offset detected in CVarMap::remove()");
         }
 
-        TValId find(const CVar &cVar) {
+        TValId find(const CVar &cVar) const {
             // regular lookup
-            TCont::iterator iter = cont_.find(cVar);
-            const bool found = (cont_.end() != iter);
+            const TValId *pVal = cont_.findVal(cVar);
             if (!cVar.inst) {
                 // gl variable explicitly requested
-                return (found)
-                    ? iter->second
+                return (pVal)
+                    ? *pVal
                     : VAL_INVALID;
             }
 
             // automatic fallback to gl variable
             CVar gl = cVar;
             gl.inst = /* global variable */ 0;
-            TCont::iterator iterGl = cont_.find(gl);
-            const bool foundGl = (cont_.end() != iterGl);
+            const TValId *pValGl = cont_.findVal(gl);
 
-            if (!found && !foundGl)
+            if (!pVal && !pValGl)
                 // not found anywhere
                 return VAL_INVALID;
 
             // check for clash on uid among lc/gl variable
-            CL_BREAK_IF(found && foundGl);
+            CL_BREAK_IF(pVal && pValGl);
 
-            if (found)
-                return iter->second;
-            else /* if (foundGl) */
-                return iterGl->second;
+            if (pVal)
+                return *pVal;
+            else /* if (pValGl) */
+                return *pValGl;
         }
-};
 
+        void renumber(const IdMapper &idMap) {
+            TCont dst;
+            BOOST_FOREACH(TCont::const_reference ref, cont_)
+                dst.set(ref.first, idMap(ref.second));
 
-// /////////////////////////////////////////////////////////////////////////////
-// implementation of CustomValue
-CustomValue::~CustomValue() {
-    if (CV_STRING != code_)
-        return;
+            cont_.swap(dst);
+        }
 
-    CL_BREAK_IF(!data_.str);
-    delete data_.str;
-}
+        void pack(PackWriter &dst) const {
+            dst.putUInt(cont_.size());
+            BOOST_FOREACH(TCont::const_reference ref, cont_) {
+                dst.putInt(ref.first.uid);
+                dst.putInt(ref.first.inst);
+                dst.putInt(ref.second);
+            }
+        }
 
-CustomValue::CustomValue(const CustomValue &ref):
-    code_(ref.code_),
-    data_(ref.data_)
-{
-    if (CV_STRING == code_)
-        data_.str = new std::string(*ref.data_.str);
-}
+        void unpack(PackReader &src) {
+            for (unsigned long cnt = src.getUInt(); cnt; --cnt) {
+                CVar cVar;
+                cVar.uid  = src.getInt();
+                cVar.inst = src.getInt();
+                cont_.set(cVar, static_cast<TValId>(src.getInt()));
+            }
+        }
+};
 
-CustomValue& CustomValue::operator=(const CustomValue &ref) {
-    if (&ref == this)
-        return *this;
 
-    if (CV_STRING == code_) {
-        CL_BREAK_IF(!data_.str);
-        delete data_.str;
-    }
+// /////////////////////////////////////////////////////////////////////////////
+// process-wide table of string literals referred by CustomValue
+class StringTable {
+    private:
+        typedef std::map<std::string, int>          TIdByStr;
 
-    code_ = ref.code_;
-    data_ = ref.data_;
+        /// std::deque does not move the strings as it grows
+        std::deque<std::string>                     strById_;
+        TIdByStr                                    idByStr_;
 
-    if (CV_STRING == code_)
-        data_.str = new std::string(*ref.data_.str);
+    public:
+        int intern(const char *str) {
+            const std::string key(str);
+            TIdByStr::const_iterator it = idByStr_.find(key);
+            if (idByStr_.end() != it)
+                return it->second;
+
+            const int id = strById_.size();
+            strById_.push_back(key);
+            idByStr_[key] = id;
+            return id;
+        }
 
-    return *this;
+        const std::string& str(int id) const {
+            CL_BREAK_IF(id < 0 || static_cast<int>(strById_.size()) <= id);
+            return strById_[id];
+        }
+};
+
+static StringTable& strTable() {
+    static StringTable table;
+    return table;
+}
+
+// /////////////////////////////////////////////////////////////////////////////
+// implementation of CustomValue
+CustomValue::CustomValue(const char *str):
+    code_(CV_STRING)
+{
+    data_.strId = strTable().intern(str);
 }
 
 int CustomValue::uid() const {
@@ -224,8 +367,12 @@ double CustomValue::fpn() const {
 
 const std::string& CustomValue::str() const {
     CL_BREAK_IF(CV_STRING != code_);
-    CL_BREAK_IF(!data_.str);
-    return *data_.str;
+    return strTable().str(data_.strId);
+}
+
+int CustomValue::strId() const {
+    CL_BREAK_IF(CV_STRING != code_);
+    return data_.strId;
 }
 
 /// eliminates the warning 'comparing floating point with == or != is unsafe'
@@ -251,8 +398,8 @@ bool operator==(const CustomValue &a, const CustomValue &b) {
             return areEqual(a.data_.fpn, b.data_.fpn);
 
         case CV_STRING:
-            CL_BREAK_IF(!a.data_.str || !b.data_.str);
-            return !a.data_.str->compare(*b.data_.str);
+            // interned strings
+            return (a.data_.strId == b.data_.strId);
 
         case CV_INT_RANGE:
             return (a.data_.rng == b.data_.rng);
@@ -330,10 +477,93 @@ inline EBlockKind bkFromClt(const TObjType clt) {
         : BK_DATA_OBJ;
 }
 
+// /////////////////////////////////////////////////////////////////////////////
+// compact images of heap entities, see SymHeapCore::pack()
+enum EPackedEnt {
+    PE_RELEASED,
+    PE_BLOCK,
+    PE_OBJECT,
+    PE_VALUE,
+    PE_RANGE,
+    PE_COMP,
+    PE_CUSTOM,
+    PE_ROOT
+};
+
+void packRange(PackWriter &dst, const IR::Range &rng) {
+    dst.putInt(rng.lo);
+    dst.putInt(rng.hi);
+    dst.putInt(rng.alignment);
+}
+
+IR::Range unpackRange(PackReader &src) {
+    IR::Range rng;
+    rng.lo          = src.getInt();
+    rng.hi          = src.getInt();
+    rng.alignment   = src.getInt();
+    return rng;
+}
+
+void packCustom(PackWriter &dst, const CustomValue &cv) {
+    const ECustomValue code = cv.code();
+    dst.putUInt(code);
+    switch (code) {
+        case CV_INVALID:
+            break;
+
+        case CV_FNC:
+            dst.putInt(cv.uid());
+            break;
+
+        case CV_INT_RANGE:
+            packRange(dst, cv.rng());
+            break;
+
+        case CV_REAL:
+            dst.putReal(cv.fpn());
+            break;
+
+        case CV_STRING:
+            // the IDs of strings are valid process-wide
+            dst.putInt(cv.strId());
+            break;
+    }
+}
+
+CustomValue unpackCustom(PackReader &src) {
+    const ECustomValue code = static_cast<ECustomValue>(src.getUInt());
+    switch (code) {
+        case CV_FNC:
+            return CustomValue(static_cast<int>(src.getInt()));
+
+        case CV_INT_RANGE:
+            return CustomValue(unpackRange(src));
+
+        case CV_REAL:
+            return CustomValue(src.getReal());
+
+        case CV_STRING:
+            return CustomValue(strTable().str(src.getInt()).c_str());
+
+        case CV_INVALID:
+        default:
+            return CustomValue();
+    }
+}
+
 class AbstractHeapEntity {
     public:
         virtual AbstractHeapEntity* clone() const = 0;
 
+        /// translate all IDs referred by the entity, see compactIds()
+        virtual void renumber(const IdMapper &) = 0;
+
+        /// the tag to be stored in front of the image written by pack()
+        virtual EPackedEnt packedAs() const = 0;
+
+        /// write the fields of the entity, the constructors read them back
+        virtual void pack(PackWriter &) const = 0;
+
     protected:
         virtual ~AbstractHeapEntity() { }
         friend class EntStore<AbstractHeapEntity>;
@@ -368,9 +598,35 @@ struct BlockEntity: public AbstractHeapEntity {
     {
     }
 
+    BlockEntity(PackReader &src):
+        code    (static_cast<EBlockKind>(src.getUInt())),
+        root    (static_cast<TValId>    (src.getInt())),
+        off     (src.getInt()),
+        size    (src.getInt()),
+        value   (static_cast<TValId>    (src.getInt()))
+    {
+    }
+
     virtual BlockEntity* clone() const {
         return new BlockEntity(*this);
     }
+
+    virtual EPackedEnt packedAs() const {
+        return PE_BLOCK;
+    }
+
+    virtual void pack(PackWriter &dst) const {
+        dst.putUInt(code);
+        dst.putInt(root);
+        dst.putInt(off);
+        dst.putInt(size);
+        dst.putInt(value);
+    }
+
+    virtual void renumber(const IdMapper &idMap) {
+        root    = idMap(root);
+        value   = idMap(value);
+    }
 };
 
 struct HeapObject: public BlockEntity {
@@ -384,9 +640,26 @@ struct HeapObject: public BlockEntity {
     {
     }
 
+    HeapObject(PackReader &src):
+        BlockEntity(src),
+        clt(src.getPtr<TObjType>()),
+        extRefCnt(src.getInt())
+    {
+    }
+
     virtual HeapObject* clone() const {
         return new HeapObject(*this);
     }
+
+    virtual EPackedEnt packedAs() const {
+        return PE_OBJECT;
+    }
+
+    virtual void pack(PackWriter &dst) const {
+        BlockEntity::pack(dst);
+        dst.putPtr(clt);
+        dst.putInt(extRefCnt);
+    }
 };
 
 struct BaseValue: public AbstractHeapEntity {
@@ -405,32 +678,106 @@ struct BaseValue: public AbstractHeapEntity {
     {
     }
 
+    BaseValue(PackReader &src):
+        code    (static_cast<EValueTarget>(src.getUInt())),
+        origin  (static_cast<EValueOrigin>(src.getUInt())),
+        valRoot (static_cast<TValId>      (src.getInt())),
+        anchor  (static_cast<TValId>      (src.getInt())),
+        offRoot (src.getInt())
+    {
+        src.getSet(usedBy);
+    }
+
     virtual BaseValue* clone() const {
         return new BaseValue(*this);
     }
+
+    virtual EPackedEnt packedAs() const {
+        return PE_VALUE;
+    }
+
+    virtual void pack(PackWriter &dst) const {
+        dst.putUInt(code);
+        dst.putUInt(origin);
+        dst.putInt(valRoot);
+        dst.putInt(anchor);
+        dst.putInt(offRoot);
+        dst.putSet(usedBy);
+    }
+
+    virtual void renumber(const IdMapper &idMap) {
+        valRoot = idMap(valRoot);
+        anchor  = idMap(anchor);
+        idMap.renumberSet(usedBy);
+    }
 };
 
 /// maintains a list of dependent values
 struct ReferableValue: public BaseValue {
     TValList                        dependentValues;
 
+    virtual void renumber(const IdMapper &idMap) {
+        BaseValue::renumber(idMap);
+        BOOST_FOREACH(TValId &val, dependentValues)
+            val = idMap(val);
+    }
+
+    virtual void pack(PackWriter &dst) const {
+        BaseValue::pack(dst);
+        dst.putUInt(dependentValues.size());
+        BOOST_FOREACH(const TValId val, dependentValues)
+            dst.putInt(val);
+    }
+
     // unless clone() is properly overridden, the constructor cannot be public
     protected:
     ReferableValue(EValueTarget code_, EValueOrigin origin_):
         BaseValue(code_, origin_)
     {
     }
+
+    ReferableValue(PackReader &src):
+        BaseValue(src)
+    {
+        for (unsigned long cnt = src.getUInt(); cnt; --cnt)
+            dependentValues.push_back(static_cast<TValId>(src.getInt()));
+    }
 };
 
 struct AnchorValue: public ReferableValue {
     TOffMap                         offMap;
 
+    virtual void renumber(const IdMapper &idMap) {
+        ReferableValue::renumber(idMap);
+        BOOST_FOREACH(TOffMap::reference ref, offMap)
+            ref.second = idMap(ref.second);
+    }
+
+    virtual void pack(PackWriter &dst) const {
+        ReferableValue::pack(dst);
+        dst.putUInt(offMap.size());
+        BOOST_FOREACH(TOffMap::const_reference ref, offMap) {
+            dst.putInt(ref.first);
+            dst.putInt(ref.second);
+        }
+    }
+
     // unless clone() is properly overridden, the constructor cannot be public
     protected:
     AnchorValue(EValueTarget code_, EValueOrigin origin_):
         ReferableValue(code_, origin_)
     {
     }
+
+    AnchorValue(PackReader &src):
+        ReferableValue(src)
+    {
+        for (unsigned long cnt = src.getUInt(); cnt; --cnt) {
+            const TOffset off = src.getInt();
+            const TValId val = static_cast<TValId>(src.getInt());
+            offMap.insert(offMap.end(), TOffMap::value_type(off, val));
+        }
+    }
 };
 
 struct RangeValue: public AnchorValue {
@@ -442,9 +789,24 @@ struct RangeValue: public AnchorValue {
     {
     }
 
+    RangeValue(PackReader &src):
+        AnchorValue(src),
+        range(unpackRange(src))
+    {
+    }
+
     virtual RangeValue* clone() const {
         return new RangeValue(*this);
     }
+
+    virtual EPackedEnt packedAs() const {
+        return PE_RANGE;
+    }
+
+    virtual void pack(PackWriter &dst) const {
+        AnchorValue::pack(dst);
+        packRange(dst, range);
+    }
 };
 
 struct CompValue: public BaseValue {
@@ -456,9 +818,31 @@ struct CompValue: public BaseValue {
     {
     }
 
+    CompValue(PackReader &src):
+        BaseValue(src),
+        compObj(static_cast<TObjId>(src.getInt()))
+    {
+    }
+
     virtual BaseValue* clone() const {
         return new CompValue(*this);
     }
+
+    virtual EPackedEnt packedAs() const {
+        return PE_COMP;
+    }
+
+    virtual void pack(PackWriter &dst) const {
+        BaseValue::pack(dst);
+        dst.putInt(compObj);
+    }
+
+    virtual void renumber(const IdMapper &idMap) {
+        BaseValue::renumber(idMap);
+
+        // the composite object may have been released meanwhile
+        compObj = idMap(compObj);
+    }
 };
 
 struct InternalCustomValue: public ReferableValue {
@@ -469,9 +853,24 @@ struct InternalCustomValue: public ReferableValue {
     {
     }
 
+    InternalCustomValue(PackReader &src):
+        ReferableValue(src),
+        customData(unpackCustom(src))
+    {
+    }
+
     virtual InternalCustomValue* clone() const {
         return new InternalCustomValue(*this);
     }
+
+    virtual EPackedEnt packedAs() const {
+        return PE_CUSTOM;
+    }
+
+    virtual void pack(PackWriter &dst) const {
+        ReferableValue::pack(dst);
+        packCustom(dst, customData);
+    }
 };
 
 struct RootValue: public AnchorValue {
@@ -491,55 +890,227 @@ struct RootValue: public AnchorValue {
     {
     }
 
+    RootValue(PackReader &src):
+        AnchorValue(src)
+    {
+        cVar.uid        = src.getInt();
+        cVar.inst       = src.getInt();
+        size            = unpackRange(src);
+
+        for (unsigned long cnt = src.getUInt(); cnt; --cnt) {
+            const TObjId obj = static_cast<TObjId>(src.getInt());
+            const EBlockKind code = static_cast<EBlockKind>(src.getUInt());
+            liveObjs.insert(liveObjs.end(), TLiveObjs::value_type(obj, code));
+        }
+
+        src.getSet(usedByGl);
+
+        for (unsigned long cnt = src.getUInt(); cnt; --cnt) {
+            const TOffset beg = src.getInt();
+            const TOffset end = src.getInt();
+            const TObjId obj = static_cast<TObjId>(src.getInt());
+            arena += TMemItem(TMemChunk(beg, end), obj);
+        }
+
+        lastKnownClt    = src.getPtr<TObjType>();
+        protoLevel      = src.getInt();
+    }
+
     virtual RootValue* clone() const {
         return new RootValue(*this);
     }
+
+    virtual EPackedEnt packedAs() const {
+        return PE_ROOT;
+    }
+
+    virtual void pack(PackWriter &dst) const {
+        AnchorValue::pack(dst);
+        dst.putInt(cVar.uid);
+        dst.putInt(cVar.inst);
+        packRange(dst, size);
+
+        dst.putUInt(liveObjs.size());
+        BOOST_FOREACH(TLiveObjs::const_reference ref, liveObjs) {
+            dst.putInt(ref.first);
+            dst.putUInt(ref.second);
+        }
+
+        dst.putSet(usedByGl);
+
+        std::vector<TMemItem> items;
+        arena.items(items);
+        dst.putUInt(items.size());
+        BOOST_FOREACH(const TMemItem &item, items) {
+            dst.putInt(item.first.first);
+            dst.putInt(item.first.second);
+            dst.putInt(item.second);
+        }
+
+        dst.putPtr(lastKnownClt);
+        dst.putInt(protoLevel);
+    }
+
+    virtual void renumber(const IdMapper &idMap) {
+        AnchorValue::renumber(idMap);
+
+        TLiveObjs dst;
+        BOOST_FOREACH(TLiveObjs::const_reference ref, liveObjs)
+            dst.insert(dst.end(), TLiveObjs::value_type(idMap(ref.first),
+                                                        ref.second));
+        liveObjs.swap(dst);
+
+        idMap.renumberSet(usedByGl);
+        arena.renumber(idMap);
+    }
 };
 
 // cppcheck-suppress noConstructor
 class CustomValueMapper {
     private:
-        typedef std::map<int /* uid */, TValId>                 TCustomByUid;
-        typedef std::map<IR::TInt, TValId>                      TCustomByNum;
-        typedef std::map<double, TValId>                        TCustomByReal;
-        typedef std::map<std::string, TValId>                   TCustomByString;
+        typedef PersistentMap<int /* uid */, TValId>            TCustomByUid;
+        typedef PersistentMap<IR::TInt, TValId>                 TCustomByNum;
+        typedef PersistentMap<double, TValId>                   TCustomByReal;
+        typedef PersistentMap<int /* strId */, TValId>          TCustomByString;
 
         TCustomByUid        fncMap;
         TCustomByNum        numMap;
         TCustomByReal       fpnMap;
         TCustomByString     strMap;
-        TValId              inval_;
+
+        template <class TMap>
+        static TValId findIn(const TMap &map, const typename TMap::key_type &key)
+        {
+            const TValId *pVal = map.findVal(key);
+            return (pVal)
+                ? *pVal
+                : VAL_INVALID;
+        }
 
     public:
         RefCounter          refCnt;
 
     public:
-        TValId& lookup(const CustomValue &item) {
+        /// return the value wrapping the given custom value, VAL_INVALID if none
+        TValId find(const CustomValue &item) const {
             const ECustomValue code = item.code();
             switch (code) {
                 case CV_INVALID:
                 default:
-                    CL_BREAK_IF("invalid call of CustomValueMapper::lookup()");
-                    return inval_ = VAL_INVALID;
+                    CL_BREAK_IF("invalid call of CustomValueMapper::find()");
+                    return VAL_INVALID;
+
+                case CV_FNC:
+                    return findIn(fncMap, item.uid());
+
+                case CV_INT_RANGE:
+                    CL_BREAK_IF(!isSingular(item.rng()));
+                    return findIn(numMap, item.rng().lo);
+
+                case CV_REAL:
+                    return findIn(fpnMap, item.fpn());
+
+                case CV_STRING:
+                    return findIn(strMap, item.strId());
+            }
+        }
+
+        /// register the value wrapping the given custom value
+        void insert(const CustomValue &item, TValId val) {
+            CL_BREAK_IF(VAL_INVALID != this->find(item));
+
+            const ECustomValue code = item.code();
+            switch (code) {
+                case CV_INVALID:
+                    CL_BREAK_IF("invalid call of CustomValueMapper::insert()");
+                    break;
 
                 case CV_FNC:
-                    return assignInvalidIfNotFound(fncMap, item.uid());
+                    fncMap.set(item.uid(), val);
+                    break;
 
                 case CV_INT_RANGE:
                     CL_BREAK_IF(!isSingular(item.rng()));
-                    return assignInvalidIfNotFound(numMap, item.rng().lo);
+                    numMap.set(item.rng().lo, val);
+                    break;
 
                 case CV_REAL:
-                    return assignInvalidIfNotFound(fpnMap, item.fpn());
+                    fpnMap.set(item.fpn(), val);
+                    break;
 
                 case CV_STRING:
-                    return assignInvalidIfNotFound(strMap, item.str());
+                    strMap.set(item.strId(), val);
+                    break;
             }
         }
+
+        void renumber(const IdMapper &idMap) {
+            renumberIn(fncMap, idMap);
+            renumberIn(numMap, idMap);
+            renumberIn(fpnMap, idMap);
+            renumberIn(strMap, idMap);
+        }
+
+        void pack(PackWriter &dst) const {
+            dst.putUInt(fncMap.size());
+            BOOST_FOREACH(TCustomByUid::const_reference ref, fncMap) {
+                dst.putInt(ref.first);
+                dst.putInt(ref.second);
+            }
+
+            dst.putUInt(numMap.size());
+            BOOST_FOREACH(TCustomByNum::const_reference ref, numMap) {
+                dst.putInt(ref.first);
+                dst.putInt(ref.second);
+            }
+
+            dst.putUInt(fpnMap.size());
+            BOOST_FOREACH(TCustomByReal::const_reference ref, fpnMap) {
+                dst.putReal(ref.first);
+                dst.putInt(ref.second);
+            }
+
+            dst.putUInt(strMap.size());
+            BOOST_FOREACH(TCustomByString::const_reference ref, strMap) {
+                dst.putInt(ref.first);
+                dst.putInt(ref.second);
+            }
+        }
+
+        void unpack(PackReader &src) {
+            for (unsigned long cnt = src.getUInt(); cnt; --cnt) {
+                const int uid = src.getInt();
+                fncMap.set(uid, static_cast<TValId>(src.getInt()));
+            }
+
+            for (unsigned long cnt = src.getUInt(); cnt; --cnt) {
+                const IR::TInt num = src.getInt();
+                numMap.set(num, static_cast<TValId>(src.getInt()));
+            }
+
+            for (unsigned long cnt = src.getUInt(); cnt; --cnt) {
+                const double fpn = src.getReal();
+                fpnMap.set(fpn, static_cast<TValId>(src.getInt()));
+            }
+
+            for (unsigned long cnt = src.getUInt(); cnt; --cnt) {
+                const int strId = src.getInt();
+                strMap.set(strId, static_cast<TValId>(src.getInt()));
+            }
+        }
+
+    private:
+        template <class TMap>
+        static void renumberIn(TMap &map, const IdMapper &idMap) {
+            TMap dst;
+            BOOST_FOREACH(typename TMap::const_reference ref, map)
+                dst.set(ref.first, idMap(ref.second));
+
+            map.swap(dst);
+        }
 };
 
-// FIXME: std::set is not a good candidate for base class
-struct TValSetWrapper: public TValSet {
+struct TValSetWrapper: public PersistentSet<TValId> {
     RefCounter refCnt;
 };
 
@@ -634,6 +1205,10 @@ struct SymHeapCore::Private {
 
     void trimCustomValue(TValId val, const IR::Range &win);
 
+    void renumberIds(const IdMapper &idMap);
+
+    static AbstractHeapEntity* unpackEnt(PackReader &src);
+
     private:
         // intentionally not implemented
         Private& operator=(const Private &);
@@ -985,9 +1560,8 @@ bool SymHeapCore::Private::writeCharToString(
 
     // update the mapping of the string being assigned
     CL_DEBUG("CV_STRING replaced as a consequence of data reinterpretation");
-    RefCntLib<RCO_NON_VIRT>::requireExclusivity(this->cValueMap);
     const CustomValue cvStr(str.c_str());
-    TValId &valStr = this->cValueMap->lookup(cvStr);
+    TValId valStr = this->cValueMap->find(cvStr);
 
     if (VAL_INVALID == valStr) {
         // CV_STRING not found, wrap it as a new heap value
@@ -995,6 +1569,9 @@ bool SymHeapCore::Private::writeCharToString(
         InternalCustomValue *dstData;
         this->ents.getEntRW(&dstData, valStr);
         dstData->customData = cvStr;
+
+        RefCntLib<RCO_NON_VIRT>::requireExclusivity(this->cValueMap);
+        this->cValueMap->insert(cvStr, valStr);
     }
 
     *pValDst = valStr;
@@ -1392,8 +1969,6 @@ SymHeapCore::Private::Private(Trace::Node *trace):
     coinDb      (new CoincidenceDb),
     neqDb       (new NeqDb)
 {
-    // allocate a root-value for VAL_NULL
-    this->assignId(new RootValue(VT_INVALID, VO_INVALID));
 }
 
 SymHeapCore::Private::Private(const SymHeapCore::Private &ref):
@@ -1581,6 +2156,139 @@ unsigned SymHeapCore::lastId() const {
     return d->ents.lastId<unsigned>();
 }
 
+void SymHeapCore::Private::renumberIds(const IdMapper &idMap) {
+    // translate the IDs referred by entities (this clones the shared ones)
+    const int last = this->ents.lastId<int>();
+    for (int id = 0; id <= last; ++id)
+        if (this->ents.isValidEnt(id))
+            this->ents.getEntRW(id)->renumber(idMap);
+
+    // move the entities to their new IDs
+    this->ents.renumber(idMap.idMap());
+
+    // translate the IDs used in side tables
+    PersistentSet<TValId> roots;
+    BOOST_FOREACH(const TValId root, *this->liveRoots)
+        roots.insertOnce(idMap(root));
+
+    RefCntLib<RCO_NON_VIRT>::requireExclusivity(this->liveRoots);
+    this->liveRoots->swap(roots);
+
+    RefCntLib<RCO_NON_VIRT>::requireExclusivity(this->cVarMap);
+    this->cVarMap->renumber(idMap);
+
+    RefCntLib<RCO_NON_VIRT>::requireExclusivity(this->cValueMap);
+    this->cValueMap->renumber(idMap);
+
+    RefCntLib<RCO_NON_VIRT>::requireExclusivity(this->coinDb);
+    this->coinDb->renumber(idMap);
+
+    RefCntLib<RCO_NON_VIRT>::requireExclusivity(this->neqDb);
+    this->neqDb->renumber(idMap);
+}
+
+AbstractHeapEntity* SymHeapCore::Private::unpackEnt(PackReader &src) {
+    const EPackedEnt tag = static_cast<EPackedEnt>(src.getUInt());
+    switch (tag) {
+        case PE_RELEASED:
+            return 0;
+
+        case PE_BLOCK:
+            return new BlockEntity(src);
+
+        case PE_OBJECT:
+            return new HeapObject(src);
+
+        case PE_VALUE:
+            return new BaseValue(src);
+
+        case PE_RANGE:
+            return new RangeValue(src);
+
+        case PE_COMP:
+            return new CompValue(src);
+
+        case PE_CUSTOM:
+            return new InternalCustomValue(src);
+
+        case PE_ROOT:
+            return new RootValue(src);
+    }
+
+    CL_BREAK_IF("corrupted image in SymHeapCore::Private::unpackEnt()");
+    return 0;
+}
+
+void SymHeapCore::pack(PackWriter &dst) const {
+    const int cnt = 1 + d->ents.lastId<int>();
+    dst.putUInt(cnt);
+    for (int id = 0; id < cnt; ++id) {
+        if (!d->ents.isValidEnt(id)) {
+            dst.putUInt(PE_RELEASED);
+            continue;
+        }
+
+        const AbstractHeapEntity *ent = d->ents.getEntRO(id);
+        dst.putUInt(ent->packedAs());
+        ent->pack(dst);
+    }
+
+    dst.putSet(*d->liveRoots);
+    d->cVarMap->pack(dst);
+    d->cValueMap->pack(dst);
+    d->coinDb->pack(dst);
+    d->neqDb->pack(dst);
+}
+
+void SymHeapCore::unpack(PackReader &src) {
+    Private *img = new Private(this->traceNode());
+
+    const unsigned long cnt = src.getUInt();
+    for (unsigned long id = 0; id < cnt; ++id) {
+        AbstractHeapEntity *ent = Private::unpackEnt(src);
+        if (ent)
+            img->ents.assignId(static_cast<int>(id), ent);
+    }
+
+    // released IDs at the end are not reused either
+    img->ents.reserveIds(cnt);
+
+    std::vector<TValId> roots;
+    src.getSet(roots);
+    BOOST_FOREACH(const TValId root, roots)
+        img->liveRoots->insertOnce(root);
+
+    img->cVarMap->unpack(src);
+    img->cValueMap->unpack(src);
+    img->coinDb->unpack(src);
+    img->neqDb->unpack(src);
+
+    delete d;
+    d = img;
+}
+
+bool SymHeapCore::compactIds() {
+#if SH_COMPACT_IDS_THR
+    const unsigned cntIds = 1U + this->lastId();
+    if (cntIds < /* not worth it */ 0x40U)
+        return false;
+
+    const IdMapper idMap(d->ents);
+    const unsigned cntLive = idMap.cntLive();
+    if (cntIds <= SH_COMPACT_IDS_THR * cntLive)
+        return false;
+
+    CL_DEBUG("SymHeapCore::compactIds() renumbers " << cntLive
+            << " entities, " << (cntIds - cntLive) << " IDs reclaimed");
+
+    d->renumberIds(idMap);
+    this->remapIds(idMap.idMap());
+    return true;
+#else
+    return false;
+#endif
+}
+
 TValId SymHeapCore::valClone(TValId val) {
     const BaseValue *valData;
     d->ents.getEntRO(&valData, val);
@@ -1683,7 +2391,7 @@ TValId SymHeapCore::Private::dupRoot(TValId rootAt) {
     rootDataDst->protoLevel         = rootDataSrc->protoLevel;
 
     RefCntLib<RCO_NON_VIRT>::requireExclusivity(this->liveRoots);
-    this->liveRoots->insert(imageAt);
+    this->liveRoots->insertOnce(imageAt);
 
     BOOST_FOREACH(TLiveObjs::const_reference item, rootDataSrc->liveObjs)
         this->copySingleLiveBlock(imageAt, rootDataDst,
@@ -1837,6 +2545,9 @@ SymHeapCore::SymHeapCore(TStorRef stor, Trace::Node *trace):
 {
     CL_BREAK_IF(!&stor_);
 
+    // allocate a root-value for VAL_NULL
+    d->assignId(new RootValue(VT_INVALID, VO_INVALID));
+
     // initialize VAL_ADDR_OF_RET
     const TValId addrRet = d->valCreate(VT_ON_STACK, VO_ASSIGNED);
     CL_BREAK_IF(VAL_ADDR_OF_RET != addrRet);
@@ -1848,6 +2559,16 @@ SymHeapCore::SymHeapCore(const SymHeapCore &ref):
     d(new Private(*ref.d))
 {
     CL_BREAK_IF(!&stor_);
+    ++::copyStats.cntCopied;
+}
+
+SymHeapCore::SymHeapCore(SymHeapCore &&ref):
+    stor_(ref.stor_),
+    d(ref.d)
+{
+    CL_BREAK_IF(!d);
+    ref.d = 0;
+    ++::copyStats.cntMoved;
 }
 
 SymHeapCore::~SymHeapCore() {
@@ -1861,6 +2582,16 @@ SymHeapCore& SymHeapCore::operator=(const SymHeapCore &ref) {
 
     delete d;
     d = new Private(*ref.d);
+    ++::copyStats.cntCopied;
+    return *this;
+}
+
+SymHeapCore& SymHeapCore::operator=(SymHeapCore &&ref) {
+    CL_BREAK_IF(&ref == this);
+    CL_BREAK_IF(&stor_ != &ref.stor_);
+
+    swapValues(this->d, ref.d);
+    ++::copyStats.cntMoved;
     return *this;
 }
 
@@ -2151,9 +2882,8 @@ TValId SymHeapCore::Private::wrapIntVal(const IR::TInt num) {
         return VAL_TRUE;
 
     // CV_INT values are supposed to be reused if they exist already
-    RefCntLib<RCO_NON_VIRT>::requireExclusivity(this->cValueMap);
     const CustomValue cvRng(IR::rngFromNum(num));
-    TValId &valInt = this->cValueMap->lookup(cvRng);
+    TValId valInt = this->cValueMap->find(cvRng);
 
     if (VAL_INVALID == valInt) {
         // CV_INT_RANGE not found, wrap it as a new heap value
@@ -2161,6 +2891,9 @@ TValId SymHeapCore::Private::wrapIntVal(const IR::TInt num) {
         InternalCustomValue *intData;
         this->ents.getEntRW(&intData, valInt);
         intData->customData = cvRng;
+
+        RefCntLib<RCO_NON_VIRT>::requireExclusivity(this->cValueMap);
+        this->cValueMap->insert(cvRng, valInt);
     }
 
     return valInt;
@@ -2922,6 +3655,7 @@ TObjId SymHeapCore::objAt(TValId at, TObjType clt) {
     bool liveObjFound = false;
     bool cltExactMatch = false;
     bool cltClassMatch = false;
+    const CodeStorage::TypeDb &types = stor_.types;
 
     // go through the objects in the given interval
     BOOST_FOREACH(const TObjId obj, candidates) {
@@ -2957,7 +3691,9 @@ TObjId SymHeapCore::objAt(TValId at, TObjType clt) {
         if (cltExactMatch)
             continue;
 
-        if (*cltNow == *clt) {
+        if (types.canonical(cltNow) == types.canonical(clt)
+                || *cltNow == *clt)
+        {
             cltClassMatch = true;
             goto update_best;
         }
@@ -3067,7 +3803,7 @@ TValId SymHeapCore::addrOfVar(CVar cv, bool createIfNeeded) {
 
     // mark the root as live
     RefCntLib<RCO_NON_VIRT>::requireExclusivity(d->liveRoots);
-    d->liveRoots->insert(addr);
+    d->liveRoots->insertOnce(addr);
 
     // store the address for next wheel
     RefCntLib<RCO_NON_VIRT>::requireExclusivity(d->cVarMap);
@@ -3108,7 +3844,7 @@ TValId SymHeapCore::heapAlloc(const TSizeRange &size) {
 
     // mark the root as live
     RefCntLib<RCO_NON_VIRT>::requireExclusivity(d->liveRoots);
-    d->liveRoots->insert(addr);
+    d->liveRoots->insertOnce(addr);
 
     // initialize meta-data
     RootValue *rootData;
@@ -3317,8 +4053,7 @@ TValId SymHeapCore::valWrapCustom(CustomValue cVal) {
         return val;
     }
 
-    RefCntLib<RCO_NON_VIRT>::requireExclusivity(d->cValueMap);
-    TValId &val = d->cValueMap->lookup(cVal);
+    TValId val = d->cValueMap->find(cVal);
     if (VAL_INVALID != val)
         // custom value already wrapped, we have to reuse it
         return val;
@@ -3328,6 +4063,9 @@ TValId SymHeapCore::valWrapCustom(CustomValue cVal) {
     InternalCustomValue *valData;
     d->ents.getEntRW(&valData, val);
     valData->customData = cVal;
+
+    RefCntLib<RCO_NON_VIRT>::requireExclusivity(d->cValueMap);
+    d->cValueMap->insert(cVal, val);
     return val;
 }
 
@@ -3349,7 +4087,7 @@ const CustomValue& SymHeapCore::valUnwrapCustom(TValId val) const
     }
 
     // check the consistency of backward mapping
-    CL_BREAK_IF(val != d->cValueMap->lookup(valData->customData));
+    CL_BREAK_IF(val != d->cValueMap->find(valData->customData));
 
     return cv;
 }
@@ -3488,14 +4226,24 @@ SymHeap::SymHeap(const SymHeap &ref):
     RefCntLib<RCO_NON_VIRT>::enter(d);
 }
 
+SymHeap::SymHeap(SymHeap &&ref):
+    SymHeapCore(std::move(ref)),
+    d(ref.d)
+{
+    ref.d = 0;
+}
+
 SymHeap::~SymHeap() {
-    RefCntLib<RCO_NON_VIRT>::leave(d);
+    if (d)
+        // not moved away
+        RefCntLib<RCO_NON_VIRT>::leave(d);
 }
 
 SymHeap& SymHeap::operator=(const SymHeap &ref) {
     SymHeapCore::operator=(ref);
 
-    RefCntLib<RCO_NON_VIRT>::leave(d);
+    if (d)
+        RefCntLib<RCO_NON_VIRT>::leave(d);
 
     d = ref.d;
     RefCntLib<RCO_NON_VIRT>::enter(d);
@@ -3503,6 +4251,12 @@ SymHeap& SymHeap::operator=(const SymHeap &ref) {
     return *this;
 }
 
+SymHeap& SymHeap::operator=(SymHeap &&ref) {
+    SymHeapCore::operator=(std::move(ref));
+    swapValues(this->d, ref.d);
+    return *this;
+}
+
 void SymHeap::swap(SymHeapCore &baseRef) {
     // swap base
     SymHeapCore::swap(baseRef);
@@ -3512,6 +4266,56 @@ void SymHeap::swap(SymHeapCore &baseRef) {
     swapValues(this->d, ref.d);
 }
 
+void SymHeap::pack(PackWriter &dst) const {
+    SymHeapCore::pack(dst);
+
+    const int cnt = 1 + d->absRoots.lastId<int>();
+    dst.putUInt(cnt);
+    for (int root = 0; root < cnt; ++root) {
+        if (!d->absRoots.isValidEnt(root)) {
+            dst.putUInt(OK_CONCRETE);
+            continue;
+        }
+
+        const AbstractRoot *aData = d->absRoots.getEntRO(root);
+        dst.putUInt(aData->kind);
+        dst.putInt(aData->bOff.head);
+        dst.putInt(aData->bOff.next);
+        dst.putInt(aData->bOff.prev);
+        dst.putInt(aData->minLength);
+    }
+}
+
+void SymHeap::unpack(PackReader &src) {
+    SymHeapCore::unpack(src);
+
+    RefCntLib<RCO_NON_VIRT>::leave(d);
+    d = new Private;
+
+    const int cnt = src.getUInt();
+    for (int root = 0; root < cnt; ++root) {
+        const EObjKind kind = static_cast<EObjKind>(src.getUInt());
+        if (OK_CONCRETE == kind)
+            continue;
+
+        BindingOff bOff;
+        bOff.head = src.getInt();
+        bOff.next = src.getInt();
+        bOff.prev = src.getInt();
+
+        AbstractRoot *aData = new AbstractRoot(kind, bOff);
+        aData->minLength = src.getInt();
+        d->absRoots.assignId(root, aData);
+    }
+
+    d->absRoots.reserveIds(cnt);
+}
+
+void SymHeap::remapIds(const std::vector<int> &idMap) {
+    RefCntLib<RCO_NON_VIRT>::requireExclusivity(d);
+    d->absRoots.renumber(idMap);
+}
+
 TValId SymHeap::valClone(TValId val) {
     const TValId dup = SymHeapCore::valClone(val);
     if (dup <= 0 || VT_RANGE == this->valTarget(val))
@@ -101,7 +101,7 @@ enum ECustomValue {
 union CustomValueData {
     int             uid;    ///< unique ID as assigned by Code Listener
     double          fpn;    ///< floating-point number
-    std::string    *str;    ///< string literal
+    int             strId;  ///< ID of an interned string literal
     IR::Range       rng;    ///< closed interval over integral domain
 };
 
@@ -114,10 +114,6 @@ class CustomValue {
         {
         }
 
-        ~CustomValue();
-        CustomValue(const CustomValue &);
-        CustomValue& operator=(const CustomValue &);
-
         explicit CustomValue(int uid):
             code_(CV_FNC)
         {
@@ -136,11 +132,8 @@ class CustomValue {
             data_.fpn = fpn;
         }
 
-        explicit CustomValue(const char *str):
-            code_(CV_STRING)
-        {
-            data_.str = new std::string(str);
-        }
+        /// the string is interned process-wide, the object stores its ID only
+        explicit CustomValue(const char *str);
 
         /// custom value classification
         ECustomValue code() const {
@@ -164,6 +157,9 @@ class CustomValue {
         /// string literal (only for CV_STRING)
         const std::string &str() const;
 
+        /// equal strings have equal IDs (only for CV_STRING)
+        int strId() const;
+
     private:
         friend bool operator==(const CustomValue &, const CustomValue &);
 
@@ -185,6 +181,9 @@ namespace Trace {
     class Node;
 }
 
+class PackReader;
+class PackWriter;
+
 /// a type used for integral offsets (changing this is known to cause problems)
 typedef IR::TInt                                        TOffset;
 
@@ -307,6 +306,12 @@ class SymHeapCore {
         /// relatively cheap operation as long as SH_COPY_ON_WRITE is enabled
         SymHeapCore& operator=(const SymHeapCore &);
 
+        /// take over the contents, the given heap can be only destroyed then
+        SymHeapCore(SymHeapCore &&);
+
+        /// exchange the contents with the given heap, no trace node is created
+        SymHeapCore& operator=(SymHeapCore &&);
+
         /// exchange the contents with the other heap (works in constant time)
         virtual void swap(SymHeapCore &);
 
@@ -322,6 +327,20 @@ class SymHeapCore {
         /// the last assigned ID of a heap entity (not necessarily still valid)
         unsigned lastId() const;
 
+        /**
+         * renumber the entities densely if most of the IDs are no longer in
+         * use, see SH_COMPACT_IDS_THR.  The relative order of IDs is preserved.
+         * @return true if the entities have been renumbered, which invalidates
+         * all IDs previously obtained from this heap
+         */
+        bool compactIds();
+
+        /// append a compact image of the heap (except its trace node) to dst
+        virtual void pack(PackWriter &dst) const;
+
+        /// replace the contents of the heap by an image produced by pack()
+        virtual void unpack(PackReader &src);
+
     public:
         /**
          * collect all objects having the given value inside
@@ -523,6 +542,11 @@ class SymHeapCore {
             return false;
         }
 
+        /// called by compactIds() to move entities of derived classes
+        virtual void remapIds(const std::vector<int> & /* idMap */) {
+            // no additional entities at this level
+        }
+
     private:
         struct Private;
         Private *d;
@@ -764,8 +788,18 @@ class SymHeap: public SymHeapCore {
         /// relatively cheap operation as long as SH_COPY_ON_WRITE is enabled
         SymHeap& operator=(const SymHeap &);
 
+        /// take over the contents, the given heap can be only destroyed then
+        SymHeap(SymHeap &&);
+
+        /// exchange the contents with the given heap, no trace node is created
+        SymHeap& operator=(SymHeap &&);
+
         virtual void swap(SymHeapCore &);
 
+        // just overrides (inherits the dox)
+        virtual void pack(PackWriter &dst) const;
+        virtual void unpack(PackReader &src);
+
     public:
         /**
          * return @b kind of the target. Here @b kind means concrete object,
@@ -800,6 +834,7 @@ class SymHeap: public SymHeapCore {
 
     protected:
         virtual bool hasAbstractTarget(TValId val) const;
+        virtual void remapIds(const std::vector<int> &idMap);
 
     private:
         struct Private;
@@ -808,6 +843,18 @@ class SymHeap: public SymHeapCore {
         void segMinLengthOp(ENeqOp op, TValId at, TMinLen len);
 };
 
+/// counters of symbolic heaps copied and of copies avoided, for statistics
+struct HeapCopyStats {
+    unsigned long       cntCopied;      ///< copies made by SymHeapCore
+    unsigned long       cntMoved;       ///< heaps moved instead of copied
+};
+
+/// the global instance of HeapCopyStats (zero initialized)
+HeapCopyStats& heapCopyStats();
+
+/// print the counters of heapCopyStats() as a debug message
+void printHeapCopyStats();
+
 /// enable/disable built-in self-checks (takes effect only in debug build)
 void enableProtectedMode(bool enable);
 
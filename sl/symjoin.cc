@@ -23,11 +23,13 @@
 #include <cl/cl_msg.hh>
 #include <cl/cldebug.hh>
 #include <cl/clutil.hh>
+#include <cl/storage.hh>
 
 #include "prototype.hh"
 #include "symcmp.hh"
 #include "symgc.hh"
 #include "symplot.hh"
+#include "sympolicy.hh"
 #include "symseg.hh"
 #include "symstate.hh"
 #include "symutil.hh"
@@ -185,7 +187,7 @@ struct SymJoinCtx {
         sh1(sh1_),
         sh2(sh2_),
         status(JS_USE_ANY),
-        allowThreeWay((1 < (SE_ALLOW_THREE_WAY_JOIN)) && allowThreeWay_)
+        allowThreeWay((1 < sePolicy().allowThreeWayJoin) && allowThreeWay_)
     {
         initValMaps();
     }
@@ -196,7 +198,7 @@ struct SymJoinCtx {
         sh1(sh_),
         sh2(sh_),
         status(JS_USE_ANY),
-        allowThreeWay(0 < (SE_ALLOW_THREE_WAY_JOIN))
+        allowThreeWay(0 < sePolicy().allowThreeWayJoin)
     {
         initValMaps();
     }
@@ -207,7 +209,7 @@ struct SymJoinCtx {
         sh1(sh_),
         sh2(sh_),
         status(JS_USE_ANY),
-        allowThreeWay(0 < (SE_ALLOW_THREE_WAY_JOIN))
+        allowThreeWay(0 < sePolicy().allowThreeWayJoin)
     {
         initValMaps();
     }
@@ -547,10 +549,8 @@ bool joinFreshObjTripple(
         if (root <= 0 || (VT_RANGE != code && hasKey(vm[/* ltr */ 0], root)))
             return true;
 
-#if SE_ALLOW_THREE_WAY_JOIN < 3
-        if (!ctx.joiningData())
+        if (sePolicy().allowThreeWayJoin < 3 && !ctx.joiningData())
             return false;
-#endif
     }
     else {
         // special values have to match (NULL not treated as special here)
@@ -753,6 +753,11 @@ TObjType joinClt(
         const TObjType          clt1,
         const TObjType          clt2)
 {
+    const CodeStorage::TypeDb &types = ctx.sh1.stor().types;
+    if (clt1 && types.canonical(clt1) == types.canonical(clt2))
+        // structurally equal types, no need for the deep check
+        return clt1;
+
     TObjType clt;
     if (joinClt(&clt, clt1, clt2))
         // symmetric join of type-info
@@ -1367,25 +1372,22 @@ bool joinCustomValues(
     }
 #endif
 
-#if !(SE_ALLOW_INT_RANGES & 0x1)
+    const int allowIntRanges = sePolicy().allowIntRanges;
+
     // avoid creation of a CV_INT_RANGE value from two CV_INT values
-    if (isSingular(rng1) && isSingular(rng2)) {
+    if (!(allowIntRanges & 0x1) && isSingular(rng1) && isSingular(rng2)) {
         const TValId vDst = ctx.dst.valCreate(VT_UNKNOWN, VO_UNKNOWN);
         return updateJoinStatus(ctx, JS_THREE_WAY)
             && defineValueMapping(ctx, v1, v2, vDst);
     }
-#endif
 
     // [experimental] widening on intervals
     if (!isSingular(rng1) && !isSingular(rng2)) {
-#if (SE_ALLOW_INT_RANGES & 0x2)
-        if (rng.lo == rng1.lo || rng.lo == rng2.lo)
+        if ((allowIntRanges & 0x2) && (rng.lo == rng1.lo || rng.lo == rng2.lo))
             rng.hi = IR::IntMax;
-#endif
-#if (SE_ALLOW_INT_RANGES & 0x4)
-        if (rng.hi == rng1.hi || rng.hi == rng2.hi)
+
+        if ((allowIntRanges & 0x4) && (rng.hi == rng1.hi || rng.hi == rng2.hi))
             rng.lo = IR::IntMin;
-#endif
     }
 
     if (!isCovered(rng, rng1) && !updateJoinStatus(ctx, JS_USE_SH2))
@@ -1769,11 +1771,10 @@ bool insertSegmentClone(
         return false;
     }
 
-#if SE_ALLOW_THREE_WAY_JOIN < 3
-    if (!ctx.joiningData() && objMinLength(shGt, seg))
+    if (sePolicy().allowThreeWayJoin < 3
+            && !ctx.joiningData() && objMinLength(shGt, seg))
         // on the way from joinSymHeaps(), some three way joins are destructive
         ctx.allowThreeWay = false;
-#endif
 
     const TValMapBidir &valMapGt = (isGt1)
         ? ctx.valMap1
@@ -2644,17 +2645,23 @@ bool validateStatus(const SymJoinCtx &ctx) {
 bool joinSymHeaps(
         EJoinStatus             *pStatus,
         SymHeap                 *pDst,
-        SymHeap                  sh1,
-        SymHeap                  sh2,
+        const SymHeap           &sh1Orig,
+        const SymHeap           &sh2Orig,
         const bool               allowThreeWay)
 {
     SJ_DEBUG("--> joinSymHeaps()");
-    TStorRef stor = sh1.stor();
-    CL_BREAK_IF(&stor != &sh2.stor());
+    TStorRef stor = sh1Orig.stor();
+    CL_BREAK_IF(&stor != &sh2Orig.stor());
+
+    // the join is allowed to materialize objects, work on copies
+    SymHeap sh1(sh1Orig);
+    SymHeap sh2(sh2Orig);
 
     // update trace
     Trace::waiveCloneOperation(sh1);
     Trace::waiveCloneOperation(sh2);
+
+    // move a fresh heap to the destination, no clone of it is needed
     *pDst = SymHeap(stor, new Trace::TransientNode("joinSymHeaps()"));
 
     // initialize symbolic join ctx
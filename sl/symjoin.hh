@@ -69,8 +69,8 @@ void joinData(
 bool joinSymHeaps(
         EJoinStatus             *pStatus,
         SymHeap                 *dst,
-        SymHeap                  sh1,
-        SymHeap                  sh2,
+        const SymHeap           &sh1,
+        const SymHeap           &sh2,
         const bool               allowThreeWay = true);
 
 /// enable/disable debugging of symjoin
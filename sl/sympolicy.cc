@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2012 Kamil Dudka <kdudka@redhat.com>
+ *
+ * This file is part of predator.
+ *
+ * predator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * predator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with predator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include "sympolicy.hh"
+
+#include <cl/cl_msg.hh>
+
+static SymExecPolicy activePolicy;
+
+const SymExecPolicy& sePolicy() {
+    return activePolicy;
+}
+
+void setSePolicy(const SymExecPolicy &policy) {
+    activePolicy = policy;
+}
+
+bool SymExecPolicy::set(const std::string &name, int value) {
+    int *pDst = 0;
+    int max;
+
+    if (name == "join_on_loop_edges_only") {
+        pDst = &this->joinOnLoopEdgesOnly;
+        max = 3;
+    }
+    else if (name == "allow_three_way_join") {
+        pDst = &this->allowThreeWayJoin;
+        max = 3;
+    }
+    else if (name == "allow_int_ranges") {
+        pDst = &this->allowIntRanges;
+        max = 7;
+    }
+    else if (name == "block_scheduler_kind") {
+        pDst = &this->blockSchedulerKind;
+        max = 3;
+    }
+    else if (name == "state_pruning_mode") {
+        pDst = &this->statePruningMode;
+        max = 3;
+    }
+    else if (name == "enable_call_cache") {
+        pDst = &this->enableCallCache;
+        max = 2;
+#if SE_STATE_ON_THE_FLY_ORDERING
+        if (1 < value) {
+            CL_WARN("join-based call cache is incompatible with "
+                    "SE_STATE_ON_THE_FLY_ORDERING");
+            return false;
+        }
+#endif
+    }
+    else if (name == "adaptive_join") {
+        pDst = &this->adaptiveJoin;
+        max = 2;
+    }
+    else if (name == "fused_block_segments") {
+        pDst = &this->fusedBlockSegments;
+        max = 1;
+    }
+    else if (name == "call_cache_max_ctx_per_fnc") {
+        pDst = &this->callCacheMaxCtxPerFnc;
+        max = 0x10000;
+    }
+    else if (name == "call_cache_max_heaps") {
+        pDst = &this->callCacheMaxHeaps;
+        max = 0x1000000;
+    }
+    else if (name == "abstract_on_call_done") {
+        // bool, handled below
+        max = 1;
+    }
+    else
+        // not a policy
+        return false;
+
+    if (value < 0 || max < value) {
+        CL_WARN("value out of range for " << name << ": " << value);
+        return false;
+    }
+
+    if (pDst)
+        *pDst = value;
+    else
+        this->abstractOnCallDone = static_cast<bool>(value);
+
+    return true;
+}
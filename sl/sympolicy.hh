@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2012 Kamil Dudka <kdudka@redhat.com>
+ *
+ * This file is part of predator.
+ *
+ * predator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * predator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with predator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_GUARD_SYM_POLICY_H
+#define H_GUARD_SYM_POLICY_H
+
+/**
+ * @file sympolicy.hh
+ * SymExecPolicy - trade-offs of the symbolic execution selectable at run-time
+ */
+
+#include "config.h"
+
+#include <string>
+
+/// defaults are taken from config.h, see the documentation of the macros there
+struct SymExecPolicy {
+    int     joinOnLoopEdgesOnly;    ///< SE_JOIN_ON_LOOP_EDGES_ONLY
+    int     allowThreeWayJoin;      ///< SE_ALLOW_THREE_WAY_JOIN
+    int     allowIntRanges;         ///< SE_ALLOW_INT_RANGES
+    int     blockSchedulerKind;     ///< SE_BLOCK_SCHEDULER_KIND
+    int     statePruningMode;       ///< SE_STATE_PRUNING_MODE
+    int     enableCallCache;        ///< SE_ENABLE_CALL_CACHE
+    int     adaptiveJoin;           ///< SE_ADAPTIVE_JOIN
+    int     fusedBlockSegments;     ///< SE_FUSED_BLOCK_SEGMENTS
+    int     callCacheMaxCtxPerFnc;  ///< SE_CALL_CACHE_MAX_CTX_PER_FNC
+    int     callCacheMaxHeaps;      ///< SE_CALL_CACHE_MAX_HEAPS
+    bool    abstractOnCallDone;     ///< SE_ABSTRACT_ON_CALL_DONE
+
+    SymExecPolicy():
+        joinOnLoopEdgesOnly (SE_JOIN_ON_LOOP_EDGES_ONLY),
+        allowThreeWayJoin   (SE_ALLOW_THREE_WAY_JOIN),
+        allowIntRanges      (SE_ALLOW_INT_RANGES),
+        blockSchedulerKind  (SE_BLOCK_SCHEDULER_KIND),
+        statePruningMode    (SE_STATE_PRUNING_MODE),
+        enableCallCache     (SE_ENABLE_CALL_CACHE),
+        adaptiveJoin        (SE_ADAPTIVE_JOIN),
+        fusedBlockSegments  (SE_FUSED_BLOCK_SEGMENTS),
+        callCacheMaxCtxPerFnc(SE_CALL_CACHE_MAX_CTX_PER_FNC),
+        callCacheMaxHeaps   (SE_CALL_CACHE_MAX_HEAPS),
+        abstractOnCallDone  (SE_ABSTRACT_ON_CALL_DONE)
+    {
+    }
+
+    /**
+     * set a policy given as NAME:VALUE, where NAME is the name of the
+     * corresponding macro in config.h in lower case without the SE_ prefix
+     * @return true if the policy was recognized and the value is valid
+     */
+    bool set(const std::string &name, int value);
+};
+
+/// the policy the symbolic execution is currently running with
+const SymExecPolicy& sePolicy();
+
+/// install the policy for the subsequent symbolic execution
+void setSePolicy(const SymExecPolicy &);
+
+#endif /* H_GUARD_SYM_POLICY_H */
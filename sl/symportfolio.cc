@@ -0,0 +1,387 @@
+/*
+ * Copyright (C) 2012 Kamil Dudka <kdudka@redhat.com>
+ *
+ * This file is part of predator.
+ *
+ * predator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * predator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with predator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include "symportfolio.hh"
+
+#include <cl/cl_msg.hh>
+#include <cl/code_listener.h>
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <poll.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <boost/foreach.hpp>
+
+// the first one is the configuration given by user, the others override it
+static const char *configs[] = {
+    "",
+    "allow_three_way_join:0",
+    "enable_call_cache:0",
+    "allow_int_ranges:0",
+    "block_scheduler_kind:3",
+    "join_on_loop_edges_only:0",
+    "allow_three_way_join:3,allow_int_ranges:0",
+#if !SE_STATE_ON_THE_FLY_ORDERING
+    "enable_call_cache:2",
+#endif
+};
+
+unsigned portfolioSize() {
+    return sizeof configs / sizeof *configs;
+}
+
+const char* portfolioConfig(unsigned idx) {
+    CL_BREAK_IF(portfolioSize() <= idx);
+    return configs[idx];
+}
+
+// /////////////////////////////////////////////////////////////////////////////
+// worker side, the messages are sent to the parent as (kind, text, '\0')
+namespace {
+
+int msgPipe = -1;
+
+void sendMsg(char kind, const char *msg) {
+    std::string rec(1, kind);
+    rec += msg;
+    rec.push_back('\0');
+
+    const char *ptr = rec.data();
+    size_t len = rec.size();
+    while (len) {
+        const ssize_t rv = write(msgPipe, ptr, len);
+        if (rv < 0 && EINTR == errno)
+            continue;
+        if (rv <= 0)
+            // the parent has gone away, nobody is interested in our results
+            _exit(EXIT_FAILURE);
+
+        ptr += rv;
+        len -= rv;
+    }
+}
+
+void sendDebug(const char *msg) { sendMsg('d', msg); }
+void sendWarn (const char *msg) { sendMsg('w', msg); }
+void sendError(const char *msg) { sendMsg('e', msg); }
+void sendNote (const char *msg) { sendMsg('n', msg); }
+
+void sendDie(const char *msg) {
+    sendMsg('e', msg);
+    _exit(EXIT_FAILURE);
+}
+
+void runWorker(int fd, unsigned idx, TPortfolioJob job, const void *data) {
+    msgPipe = fd;
+
+    struct cl_init_data init;
+    init.debug          = sendDebug;
+    init.warn           = sendWarn;
+    init.error          = sendError;
+    init.note           = sendNote;
+    init.die            = sendDie;
+    init.debug_level    = cl_debug_level();
+    cl_global_init(&init);
+
+    job(idx, data);
+
+    // do not run any atexit() handlers of the host process
+    fflush(0);
+    _exit(EXIT_SUCCESS);
+}
+
+} // namespace
+
+// /////////////////////////////////////////////////////////////////////////////
+// parent side
+namespace {
+
+struct Worker {
+    pid_t                   pid;
+    int                     fd;
+    std::string             msgs;
+    bool                    finished;   ///< exited normally
+    int                     cntErrors;
+    int                     cntWarnings;
+
+    Worker():
+        pid(-1),
+        fd(-1),
+        finished(false),
+        cntErrors(0),
+        cntWarnings(0)
+    {
+    }
+};
+
+typedef std::vector<Worker>                         TWorkers;
+
+template <class TVisitor>
+void visitMsgs(const Worker &wrk, TVisitor &visitor) {
+    const char *ptr = wrk.msgs.c_str();
+    const char *end = ptr + wrk.msgs.size();
+    while (ptr < end) {
+        const char kind = *ptr;
+        const char *text = ptr + 1;
+        ptr = text + strlen(text) + 1;
+        if (end < ptr)
+            // truncated record sent by a killed (or crashed) worker
+            break;
+
+        visitor(kind, text);
+    }
+}
+
+struct MsgCounter {
+    Worker &wrk;
+
+    MsgCounter(Worker &wrk_): wrk(wrk_) { }
+
+    void operator()(char kind, const char *) {
+        switch (kind) {
+            case 'e': ++wrk.cntErrors;   break;
+            case 'w': ++wrk.cntWarnings; break;
+        }
+    }
+};
+
+struct MsgReplay {
+    void operator()(char kind, const char *text) {
+        switch (kind) {
+            case 'd': cl_debug(text); break;
+            case 'w': cl_warn (text); break;
+            case 'e': cl_error(text); break;
+            case 'n': cl_note (text); break;
+        }
+    }
+};
+
+bool isConclusive(const Worker &wrk) {
+    return wrk.finished
+        && (wrk.cntErrors || !wrk.cntWarnings);
+}
+
+bool startWorker(
+        TWorkers                        &workers,
+        unsigned                        idx,
+        TPortfolioJob                   job,
+        const void                      *data)
+{
+    int fds[2];
+    if (pipe(fds)) {
+        CL_ERROR("portfolio: pipe() failed");
+        return false;
+    }
+
+    // anything still buffered would be printed once per worker otherwise
+    fflush(0);
+
+    const pid_t pid = fork();
+    if (pid < 0) {
+        CL_ERROR("portfolio: fork() failed");
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+
+    if (!pid) {
+        // worker
+        close(fds[0]);
+        BOOST_FOREACH(const Worker &wrk, workers)
+            if (0 <= wrk.fd)
+                close(wrk.fd);
+
+        runWorker(fds[1], idx, job, data);
+    }
+
+    close(fds[1]);
+    Worker &wrk = workers[idx];
+    wrk.pid = pid;
+    wrk.fd = fds[0];
+    return true;
+}
+
+// read whatever is available, return false on EOF
+bool readMsgs(Worker &wrk) {
+    char buf[0x1000];
+    const ssize_t rv = read(wrk.fd, buf, sizeof buf);
+    if (rv < 0 && EINTR == errno)
+        return true;
+
+    if (rv <= 0)
+        return false;
+
+    wrk.msgs.append(buf, rv);
+    return true;
+}
+
+void reapWorker(Worker &wrk, bool kill) {
+    if (kill)
+        ::kill(wrk.pid, SIGKILL);
+
+    close(wrk.fd);
+    wrk.fd = -1;
+
+    int status;
+    pid_t rv;
+    while ((rv = waitpid(wrk.pid, &status, 0)) < 0 && EINTR == errno)
+        ;
+
+    if (kill || rv < 0 || !WIFEXITED(status))
+        return;
+
+    if (EXIT_SUCCESS != WEXITSTATUS(status))
+        return;
+
+    wrk.finished = true;
+    MsgCounter counter(wrk);
+    visitMsgs(wrk, counter);
+}
+
+// wait for the first conclusive verdict, return its index or -1 if none
+int waitForWinner(TWorkers &workers) {
+    const unsigned cnt = workers.size();
+    for (;;) {
+        std::vector<struct pollfd> pfds;
+        std::vector<unsigned> idxs;
+        for (unsigned i = 0; i < cnt; ++i) {
+            if (workers[i].fd < 0)
+                continue;
+
+            struct pollfd pfd;
+            pfd.fd = workers[i].fd;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            pfds.push_back(pfd);
+            idxs.push_back(i);
+        }
+
+        if (pfds.empty())
+            // all workers are gone
+            return -1;
+
+        if (poll(&pfds[0], pfds.size(), -1) < 0) {
+            if (EINTR == errno)
+                continue;
+
+            CL_ERROR("portfolio: poll() failed");
+            return -1;
+        }
+
+        for (unsigned i = 0; i < pfds.size(); ++i) {
+            if (!pfds[i].revents)
+                continue;
+
+            Worker &wrk = workers[idxs[i]];
+            if (readMsgs(wrk))
+                continue;
+
+            reapWorker(wrk, /* kill */ false);
+            if (isConclusive(wrk))
+                return idxs[i];
+        }
+    }
+}
+
+float wallTimeSince(const struct timeval &start) {
+    struct timeval now;
+    gettimeofday(&now, 0);
+    return (now.tv_sec - start.tv_sec)
+        + 1e-6F * (now.tv_usec - start.tv_usec);
+}
+
+} // namespace
+
+int runPortfolio(unsigned cnt, TPortfolioJob job, const void *data) {
+    CL_BREAK_IF(!cnt || portfolioSize() < cnt);
+    struct timeval start;
+    gettimeofday(&start, 0);
+
+    TWorkers workers(cnt);
+    unsigned started = 0;
+    for (unsigned idx = 0; idx < cnt; ++idx) {
+        if (!startWorker(workers, idx, job, data))
+            break;
+
+        ++started;
+    }
+    workers.resize(started);
+
+    int winner = waitForWinner(workers);
+
+    unsigned cntKilled = 0;
+    BOOST_FOREACH(Worker &wrk, workers) {
+        if (wrk.fd < 0)
+            continue;
+
+        reapWorker(wrk, /* kill */ true);
+        ++cntKilled;
+    }
+
+    const bool conclusive = (0 <= winner);
+    if (!conclusive) {
+        // take the first configuration that completed the analysis at least
+        for (unsigned idx = 0; idx < started; ++idx) {
+            if (workers[idx].finished) {
+                winner = idx;
+                break;
+            }
+        }
+    }
+
+    if (winner < 0) {
+        if (started) {
+            // let the user see why the configuration given by user failed
+            MsgReplay replay;
+            visitMsgs(workers.front(), replay);
+        }
+
+        CL_ERROR("portfolio: none of " << started
+                << " configuration(s) completed the analysis");
+        return -1;
+    }
+
+    MsgReplay replay;
+    visitMsgs(workers[winner], replay);
+
+    const char *cfg = portfolioConfig(winner);
+    const std::string cfgName = (*cfg)
+        ? std::string(cfg)
+        : std::string("as given");
+
+    if (conclusive)
+        CL_NOTE("portfolio: configuration #" << winner << " (" << cfgName
+                << ") won after " << wallTimeSince(start)
+                << " s, " << cntKilled << " worker(s) killed");
+    else
+        CL_NOTE("portfolio: no conclusive verdict, taking results of "
+                "configuration #" << winner << " (" << cfgName << ")");
+
+    return winner;
+}
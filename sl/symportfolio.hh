@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2012 Kamil Dudka <kdudka@redhat.com>
+ *
+ * This file is part of predator.
+ *
+ * predator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * predator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with predator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_GUARD_SYM_PORTFOLIO_H
+#define H_GUARD_SYM_PORTFOLIO_H
+
+/**
+ * @file symportfolio.hh
+ * runPortfolio - race several engine configurations in parallel
+ */
+
+/// count of engine configurations available for the portfolio mode
+unsigned portfolioSize();
+
+/// analyzer args that select the given configuration (overriding user's args)
+const char* portfolioConfig(unsigned idx);
+
+/// runs the analysis with the configuration of the given index, then returns
+typedef void (*TPortfolioJob)(unsigned idx, const void *data);
+
+/**
+ * fork one worker per configuration and wait for the first conclusive verdict,
+ * i.e. an error found, or the analysis completed with no warnings at all.  The
+ * remaining workers are then killed and the messages of the winner are emitted
+ * as if the analysis ran in the current process.
+ * @param cnt count of configurations to race, from the beginning of the list
+ * @param job the analysis to run in each worker
+ * @param data passed to job as it is
+ * @return index of the configuration whose results have been taken, -1 if all
+ * the workers failed
+ */
+int runPortfolio(unsigned cnt, TPortfolioJob job, const void *data);
+
+#endif /* H_GUARD_SYM_PORTFOLIO_H */
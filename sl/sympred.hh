@@ -21,17 +21,15 @@
 #define H_GUARD_SYM_PRED_H
 
 #include "config.h"
+#include "persistmap.hh"
 #include "util.hh"
 
-#include <map>
-#include <set>
-
 /// a symmetric relation
 template <class TKey, bool IREFLEXIVE>
 class SymPairSet {
     protected:
         typedef std::pair<TKey /* lt */, TKey /* gt */>     TItem;
-        typedef std::set<TItem>                             TCont;
+        typedef PersistentSet<TItem>                        TCont;
         TCont cont_;
 
     public:
@@ -50,7 +48,7 @@ class SymPairSet {
 
             sortValues(k1, k2);
             const TItem item(k1, k2);
-            return cont_.insert(item)./* inserted */second;
+            return cont_.insertOnce(item);
         }
 
         bool del(TKey k1, TKey k2) {
@@ -66,7 +64,7 @@ template <class TKey, class TVal>
 class SymPairMap {
     protected:
         typedef std::pair<TKey /* lt */, TKey /* gt */>     TItem;
-        typedef std::map<TItem, TVal>                       TMap;
+        typedef PersistentMap<TItem, TVal>                  TMap;
         TMap db_;
 
     public:
@@ -86,18 +84,18 @@ class SymPairMap {
             const TItem key(k1, k2);
 
             CL_BREAK_IF(hasKey(db_, key));
-            db_[key] = val;
+            db_.set(key, val);
         }
 
         bool chk(TVal *pDst, TKey k1, TKey k2) const {
             sortValues(k1, k2);
             const TItem key(k1, k2);
 
-            typename TMap::const_iterator it = db_.find(key);
-            if (db_.end() == it)
+            const TVal *pVal = db_.findVal(key);
+            if (!pVal)
                 return false;
 
-            *pDst = it->second;
+            *pDst = *pVal;
             return true;
         }
 };
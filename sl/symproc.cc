@@ -41,6 +41,7 @@
 
 #include <stack>
 #include <stdexcept>
+#include <utility>
 #include <vector>
 
 #include <boost/foreach.hpp>
@@ -2182,7 +2183,9 @@ bool SymExecCore::execCore(
     Trace::Node *trOrig = sh_.traceNode();
     Trace::Node *trInsn = new Trace::InsnNode(trOrig, &insn, /* bin */ false);
     sh_.traceUpdate(trInsn);
-    dst.insert(sh_);
+
+    // the working heap is not used once the instruction has been executed
+    dst.insert(std::move(sh_));
     return true;
 }
 
@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2012 Kamil Dudka <kdudka@redhat.com>
+ *
+ * This file is part of predator.
+ *
+ * predator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * predator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with predator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include "symreach.hh"
+
+#include <cl/cl_msg.hh>
+#include <cl/storage.hh>
+
+#include "util.hh"
+#include "worklist.hh"
+
+#include <set>
+#include <vector>
+
+#include <boost/foreach.hpp>
+
+typedef const CodeStorage::Block                   *TBlock;
+typedef const CodeStorage::Fnc                     *TFnc;
+typedef std::set<TBlock>                            TBlockSet;
+typedef std::set<TFnc>                              TFncSet;
+
+struct ErrLabelReach::Private {
+    const std::string       label;
+    TBlockSet               labelBlocks;    ///< blocks containing the label
+    TBlockSet               relevant;       ///< blocks that may reach the label
+    TFncSet                 reachInside;    ///< may reach it before return
+    TFncSet                 reachOutside;   ///< may reach it after return
+
+    Private(const std::string &label_):
+        label(label_)
+    {
+    }
+
+    bool isErrLabel(const CodeStorage::Insn &insn) const;
+    bool updateFnc(const CodeStorage::Fnc &fnc);
+    bool updateCallers(const CodeStorage::Fnc &fnc);
+};
+
+bool ErrLabelReach::Private::isErrLabel(const CodeStorage::Insn &insn) const {
+    if (CL_INSN_LABEL != insn.code)
+        return false;
+
+    const struct cl_operand &op = insn.operands[/* name */ 0];
+    if (CL_OPERAND_CST != op.code)
+        // anonymous label
+        return false;
+
+    const struct cl_cst &cst = op.data.cst;
+    CL_BREAK_IF(CL_TYPE_STRING != cst.code);
+    const char *name = cst.data.cst_string.value;
+    return name && !this->label.compare(name);
+}
+
+// propagate the reachability backwards through the CFG of fnc
+bool ErrLabelReach::Private::updateFnc(const CodeStorage::Fnc &fnc) {
+    using namespace CodeStorage;
+
+    WorkList<TBlock> wl;
+    bool inside = false;
+
+    BOOST_FOREACH(const Block *bb, fnc.cfg) {
+        if (hasKey(this->labelBlocks, bb)) {
+            wl.schedule(bb);
+            inside = true;
+        }
+    }
+
+    // blocks calling a fnc that may reach the label, or anything indirectly
+    BOOST_FOREACH(TInsnListByFnc::const_reference item, fnc.cgNode->calls) {
+        const TFnc callee = /* zero for indirect calls */ item.first;
+        if (callee && !hasKey(this->reachInside, callee))
+            continue;
+
+        BOOST_FOREACH(const Insn *insn, /* TInsnList */ item.second)
+            wl.schedule(insn->bb);
+
+        inside = true;
+    }
+
+    if (hasKey(this->reachOutside, &fnc)) {
+        // the label may be reached in a caller after we return
+        BOOST_FOREACH(const Block *bb, fnc.cfg)
+            if (CL_INSN_RET == bb->back()->code)
+                wl.schedule(bb);
+    }
+
+    bool changed = false;
+    if (inside)
+        changed |= insertOnce(this->reachInside, &fnc);
+
+    TBlock bb;
+    while (wl.next(bb)) {
+        changed |= insertOnce(this->relevant, bb);
+        BOOST_FOREACH(const Block *pred, bb->inbound())
+            wl.schedule(pred);
+    }
+
+    return changed;
+}
+
+// check whether the label may be reached after return from fnc
+bool ErrLabelReach::Private::updateCallers(const CodeStorage::Fnc &fnc) {
+    using namespace CodeStorage;
+
+    if (hasKey(this->reachOutside, &fnc))
+        // already known
+        return false;
+
+    const CallGraph::Node *node = fnc.cgNode;
+    bool outside = !node->callbacks.empty();
+    BOOST_FOREACH(TInsnListByFnc::const_reference item, node->callers)
+        BOOST_FOREACH(const Insn *insn, /* TInsnList */ item.second)
+            if (hasKey(this->relevant, insn->bb))
+                outside = true;
+
+    return outside
+        && insertOnce(this->reachOutside, &fnc);
+}
+
+ErrLabelReach::ErrLabelReach(
+        const CodeStorage::Storage         &stor,
+        const std::string                  &label):
+    d(new Private(label))
+{
+    using namespace CodeStorage;
+
+    unsigned cntBlocks = 0;
+    BOOST_FOREACH(const Fnc *fnc, stor.fncs) {
+        if (!isDefined(*fnc))
+            continue;
+
+        CL_BREAK_IF(!fnc->cgNode);
+        BOOST_FOREACH(const Block *bb, fnc->cfg) {
+            ++cntBlocks;
+            BOOST_FOREACH(const Insn *insn, *bb)
+                if (d->isErrLabel(*insn))
+                    d->labelBlocks.insert(bb);
+        }
+    }
+
+    // reachInside propagates from callees to callers, reachOutside the other
+    // way round, so go through the call graph bottom-up and top-down resp.
+    typedef std::vector<CallGraph::TSccNodes> TSccs;
+    const TSccs &sccs = stor.callGraph.sccs;
+
+    // iterate until the fixed point is reached, the sets can only grow
+    for (bool changed = true; changed;) {
+        changed = false;
+        BOOST_FOREACH(const CallGraph::TSccNodes &scc, sccs) {
+            BOOST_FOREACH(const CallGraph::Node *node, scc) {
+                const Fnc &fnc = *node->fnc;
+                if (isDefined(fnc))
+                    changed |= d->updateFnc(fnc);
+            }
+        }
+
+        BOOST_REVERSE_FOREACH(const CallGraph::TSccNodes &scc, sccs) {
+            BOOST_FOREACH(const CallGraph::Node *node, scc) {
+                const Fnc &fnc = *node->fnc;
+                if (isDefined(fnc))
+                    changed |= d->updateCallers(fnc);
+            }
+        }
+    }
+
+    CL_DEBUG("ErrLabelReach: error label \"" << label << "\" found in "
+            << d->labelBlocks.size() << " block(s), "
+            << d->relevant.size() << " of " << cntBlocks
+            << " block(s) may reach it");
+}
+
+ErrLabelReach::~ErrLabelReach() {
+    delete d;
+}
+
+bool ErrLabelReach::canReach(const CodeStorage::Block *bb) const {
+    return hasKey(d->relevant, bb);
+}
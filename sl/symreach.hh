@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2012 Kamil Dudka <kdudka@redhat.com>
+ *
+ * This file is part of predator.
+ *
+ * predator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * predator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with predator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_GUARD_SYM_REACH_H
+#define H_GUARD_SYM_REACH_H
+
+/**
+ * @file symreach.hh
+ * ErrLabelReach - basic blocks that may lead to an error label
+ */
+
+#include <string>
+
+namespace CodeStorage {
+    class Block;
+    struct Storage;
+}
+
+/**
+ * over-approximation of basic blocks that can reach the error label on the
+ * interprocedural CFG, i.e. either in the same function, in a (transitively)
+ * called function, or after return to a caller.  Indirect calls are assumed
+ * to reach the error label, so are functions whose address is taken.
+ */
+class ErrLabelReach {
+    public:
+        /// scan the whole code model for the given error label
+        ErrLabelReach(const CodeStorage::Storage &stor, const std::string &label);
+        ~ErrLabelReach();
+
+        /// true if the error label may be reached from the given block
+        bool canReach(const CodeStorage::Block *) const;
+
+    private:
+        /// object copying is @b not allowed
+        ErrLabelReach(const ErrLabelReach &);
+
+        /// object copying is @b not allowed
+        ErrLabelReach& operator=(const ErrLabelReach &);
+
+    private:
+        struct Private;
+        Private *d;
+};
+
+#endif /* H_GUARD_SYM_REACH_H */
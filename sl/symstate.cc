@@ -24,23 +24,25 @@
 #include <cl/storage.hh>
 
 #include "symcmp.hh"
+#include "packbuf.hh"
 #include "symjoin.hh"
 #include "symplot.hh"
+#include "sympolicy.hh"
 #include "symutil.hh"
 #include "symtrace.hh"
 #include "util.hh"
 #include "worklist.hh"
 
 #include <algorithm>            // for std::copy_if
+#include <ctime>
+#include <deque>
 #include <iomanip>
 #include <map>
+#include <string>
+#include <utility>
 
 #include <boost/foreach.hpp>
 
-#if !SE_BLOCK_SCHEDULER_KIND
-#   include <queue>
-#endif
-
 // set to 'true' if you wonder why SymState matches states as it does (noisy)
 static bool debugSymState = static_cast<bool>(DEBUG_SYMSTATE);
 
@@ -98,6 +100,19 @@ void SymState::insertNew(const SymHeap &sh) {
     // drop the unneeded Trace::CloneNode
     Trace::waiveCloneOperation(*dup);
 
+    // the heap may stay here for long, do not keep the released IDs around
+    dup->compactIds();
+
+    // append the pointer to our container
+    heaps_.push_back(dup);
+}
+
+void SymState::insertNew(SymHeap &&sh) {
+    SymHeap *dup = new SymHeap(std::move(sh));
+
+    // the heap may stay here for long, do not keep the released IDs around
+    dup->compactIds();
+
     // append the pointer to our container
     heaps_.push_back(dup);
 }
@@ -111,6 +126,15 @@ bool SymState::insert(const SymHeap &sh, bool /* allowThreeWay */ ) {
     return true;
 }
 
+bool SymState::insert(SymHeap &&sh, bool /* allowThreeWay */ ) {
+    if (-1 != this->lookup(sh))
+        return false;
+
+    // add given heap to union
+    this->insertNew(std::move(sh));
+    return true;
+}
+
 void SymState::rotateExisting(const int idxA, const int idxB) {
     TList::iterator itA = heaps_.begin() + idxA;
     TList::iterator itB = heaps_.begin() + idxB;
@@ -155,6 +179,9 @@ int SymHeapUnion::lookup(const SymHeap &lookFor) const {
 // /////////////////////////////////////////////////////////////////////////////
 // SymStateWithJoin implementation
 void SymStateWithJoin::packState(unsigned idxNew, bool allowThreeWay) {
+    const SymHeap &sh = this->operator[](idxNew);
+    SymHeap result(sh.stor(), new Trace::TransientNode("packState()"));
+
     for (unsigned idxOld = 0U; idxOld < this->size();) {
         if (idxNew == idxOld) {
             // do not remove the newly inserted heap based on identity with self
@@ -165,11 +192,10 @@ void SymStateWithJoin::packState(unsigned idxNew, bool allowThreeWay) {
         SymHeap &shOld = const_cast<SymHeap &>(this->operator[](idxOld));
         SymHeap &shNew = const_cast<SymHeap &>(this->operator[](idxNew));
 
-        TStorRef stor = shNew.stor();
-        CL_BREAK_IF(&stor != &shOld.stor());
+        CL_BREAK_IF(&shNew.stor() != &shOld.stor());
 
+        // both heaps are stored in the state, they need to be joined as copies
         EJoinStatus     status;
-        SymHeap         result(stor, new Trace::TransientNode("packState()"));
         if (!joinSymHeaps(&status, &result, shOld, shNew, allowThreeWay)) {
             ++idxOld;
             continue;
@@ -207,16 +233,46 @@ void SymStateWithJoin::packState(unsigned idxNew, bool allowThreeWay) {
 }
 
 bool SymStateWithJoin::insert(const SymHeap &shNew, bool allowThreeWay) {
-#if 1 < SE_JOIN_ON_LOOP_EDGES_ONLY
-    if (!allowThreeWay)
+    if (!allowThreeWay && 1 < sePolicy().joinOnLoopEdgesOnly)
         // we are asked not to check for entailment, only isomorphism
         return SymHeapUnion::insert(shNew, allowThreeWay);
-#endif
 
+    // the given heap is copied only if it is going to be stored
+    return this->insertWork(shNew, /* pOwned */ 0, allowThreeWay);
+}
+
+bool SymStateWithJoin::insert(SymHeap &&shNew, bool allowThreeWay) {
+    if (!allowThreeWay && 1 < sePolicy().joinOnLoopEdgesOnly)
+        // we are asked not to check for entailment, only isomorphism
+        return SymHeapUnion::insert(std::move(shNew), allowThreeWay);
+
+    return this->insertWork(shNew, &shNew, allowThreeWay);
+}
+
+bool SymStateWithJoin::insertByJoin(
+        SymHeap                             &&shNew,
+        bool                                allowThreeWay,
+        bool                                *pThreeWay)
+{
+    *pThreeWay = false;
+    return this->insertWork(shNew, &shNew, allowThreeWay, pThreeWay);
+}
+
+/// if pOwned is given, it points to shNew, which can be moved to the state then
+bool SymStateWithJoin::insertWork(
+        const SymHeap                       &shNew,
+        SymHeap                             *pOwned,
+        bool                                allowThreeWay,
+        bool                                *pThreeWay)
+{
     const int cnt = this->size();
     if (!cnt) {
         // no heaps inside, insert the first now
-        this->insertNew(shNew);
+        if (pOwned)
+            this->insertNew(std::move(*pOwned));
+        else
+            this->insertNew(shNew);
+
         return true;
     }
 
@@ -227,15 +283,21 @@ bool SymStateWithJoin::insert(const SymHeap &shNew, bool allowThreeWay) {
 
     ++::cntLookups;
     for(idx = 0; idx < cnt; ++idx) {
-        const SymHeap &shOld = this->operator[](idx);
-        if (joinSymHeaps(&status, &result, shOld, shNew, allowThreeWay))
+        // a failed join may leave materialized objects in the heaps it works
+        // on, so each attempt joins fresh copies of both the heaps
+        if (joinSymHeaps(&status, &result, this->operator[](idx), shNew,
+                    allowThreeWay))
             // join succeeded
             break;
     }
 
     if (idx == cnt) {
         // nothing to join here
-        this->insertNew(shNew);
+        if (pOwned)
+            this->insertNew(std::move(*pOwned));
+        else
+            this->insertNew(shNew);
+
         return true;
     }
 
@@ -261,9 +323,14 @@ bool SymStateWithJoin::insert(const SymHeap &shNew, bool allowThreeWay) {
             debugPlot("join", 0, this->operator[](idx));
             debugPlot("join", 1, shNew);
 
-            result = shNew;
-            Trace::waiveCloneOperation(result);
-            this->swapExisting(idx, result);
+            if (pOwned) {
+                this->swapExisting(idx, *pOwned);
+            }
+            else {
+                result = shNew;
+                Trace::waiveCloneOperation(result);
+                this->swapExisting(idx, result);
+            }
 
             this->packState(idx, allowThreeWay);
             return true;
@@ -277,6 +344,9 @@ bool SymStateWithJoin::insert(const SymHeap &shNew, bool allowThreeWay) {
             debugPlot("join", 1, shNew);
             debugPlot("join", 2, result);
 
+            if (pThreeWay)
+                *pThreeWay = true;
+
             this->swapExisting(idx, result);
             this->packState(idx, allowThreeWay);
             return true;
@@ -295,26 +365,49 @@ bool SymStateWithJoin::insert(const SymHeap &shNew, bool allowThreeWay) {
 // /////////////////////////////////////////////////////////////////////////////
 // BlockScheduler implementation
 struct BlockScheduler::Private {
-#if !SE_BLOCK_SCHEDULER_KIND
-    typedef std::queue<TBlock>                              TSched;
-#elif SE_BLOCK_SCHEDULER_KIND < 3
-    typedef std::vector<TBlock>                             TSched;
-#endif
+    /// used as a queue by BFS and as a stack by DFS, unused otherwise
+    typedef std::deque<TBlock>                              TSched;
     typedef std::map<TBlock, unsigned /* cnt */>            TDone;
 
     TBlockSet           todo;
-#if SE_BLOCK_SCHEDULER_KIND < 3
     TSched              sched;
-#endif
     TDone               done;
 
     const IPendingCountProvider *pcp;
+    int                 kind;           ///< see SE_BLOCK_SCHEDULER_KIND
+
+    TBlock pickByLoad() const;
 };
 
+BlockScheduler::TBlock BlockScheduler::Private::pickByLoad() const {
+    typedef std::map<int /* cntPending */, TBlock> TLoad;
+    TLoad load;
+
+    // this really needs to be sorted in getNext()
+    BOOST_FOREACH(const TBlock bbNow, this->todo) {
+        const int cntPending = this->pcp->cntPending(bbNow);
+        load[cntPending] = bbNow;
+    }
+
+    const TLoad::const_iterator itTop = load.begin();
+    const TLoad::const_reverse_iterator itBottom = load.rbegin();
+
+    const TBlock bb = itTop->second;
+
+    CL_DEBUG("<Q> load-driven scheduler picks "
+            << bb->name() << " with "
+            << itTop->first << " pending states, the last one is "
+            << itBottom->second->name() << " with "
+            << itBottom->first << " pending states");
+
+    return bb;
+}
+
 BlockScheduler::BlockScheduler(const IPendingCountProvider &pcp):
     d(new Private)
 {
     d->pcp = &pcp;
+    d->kind = sePolicy().blockSchedulerKind;
 }
 
 BlockScheduler::BlockScheduler(const BlockScheduler &tpl):
@@ -344,17 +437,16 @@ BlockScheduler::TBlockList BlockScheduler::done() const {
 
 bool BlockScheduler::schedule(const TBlock bb) {
     if (insertOnce(d->todo, bb)) {
-#if !SE_BLOCK_SCHEDULER_KIND
-        d->sched.push(bb);
-#elif SE_BLOCK_SCHEDULER_KIND < 3
-        d->sched.push_back(bb);
-#endif
+        if (d->kind < 3)
+            d->sched.push_back(bb);
+
         return true;
     }
 
     // already in the queue
+    if (2 != d->kind)
+        return false;
 
-#if 2 == SE_BLOCK_SCHEDULER_KIND
     const int cnt = d->sched.size();
 
     // seek the given block in the queue
@@ -379,8 +471,6 @@ bool BlockScheduler::schedule(const TBlock bb) {
     Private::TSched::iterator itIdx = d->sched.begin() + idx;
     Private::TSched::iterator itTop = d->sched.begin() + (cnt - 1);
     rotate(itIdx, itTop, d->sched.end());
-#endif
-
     return false;
 }
 
@@ -390,35 +480,25 @@ bool BlockScheduler::getNext(TBlock *dst) {
 
     // select the block for processing according to the policy
     TBlock bb;
-#if !SE_BLOCK_SCHEDULER_KIND
-    bb = d->sched.front();
-    d->sched.pop();
-#elif SE_BLOCK_SCHEDULER_KIND < 3
-    bb = d->sched.back();
-    d->sched.pop_back();
-
-#else // assume load-driven scheduler
+    switch (d->kind) {
+        case 0:
+            // BFS
+            bb = d->sched.front();
+            d->sched.pop_front();
+            break;
 
-    typedef std::map<int /* cntPending */, TBlock> TLoad;
-    TLoad load;
+        case 1:
+        case 2:
+            // DFS
+            bb = d->sched.back();
+            d->sched.pop_back();
+            break;
 
-    // this really needs to be sorted in getNext()
-    BOOST_FOREACH(const TBlock bbNow, d->todo) {
-        const int cntPending = d->pcp->cntPending(bbNow);
-        load[cntPending] = bbNow;
+        default:
+            // assume load-driven scheduler
+            bb = d->pickByLoad();
     }
 
-    const TLoad::const_iterator itTop = load.begin();
-    const TLoad::const_reverse_iterator itBottom = load.rbegin();
-
-    bb = itTop->second;
-
-    CL_DEBUG("<Q> load-driven scheduler picks "
-            << bb->name() << " with "
-            << itTop->first << " pending states, the last one is "
-            << itBottom->second->name() << " with "
-            << itBottom->first << " pending states");   
-#endif
     if (1 != d->todo.erase(bb))
         CL_BREAK_IF("BlockScheduler malfunction");
 
@@ -482,6 +562,7 @@ void SymStateMarked::rotateExisting(const int idxA, const int idxB) {
 // SymStateMap implementation
 struct SymStateMap::Private {
     typedef BlockScheduler::TBlock      TBlock;
+    typedef std::vector<Trace::NodeHandle>  TTraceList;
 
     struct BlockState {
         SymStateMarked                  state;
@@ -492,16 +573,207 @@ struct SymStateMap::Private {
 
         bool                            anyHit;
 
+        /// compact image of the state while it is cold (empty otherwise)
+        std::string                     image;
+
+        /// trace nodes of the heaps stored in image (not part of the image)
+        TTraceList                      imageTraces;
+
+        const CodeStorage::Storage     *imageStor;
+
+        /// statistics of join attempts at the block, see SE_ADAPTIVE_JOIN
+        unsigned                        cntAttempts;
+        unsigned                        cntJoined;
+        unsigned                        cntThreeWay;
+        unsigned                        cntSkipped;
+        unsigned                        cntSkippedThreeWay;
+        unsigned                        failStreak;
+        unsigned                        failStreakThreeWay;
+        float                           joinTime;
+
         BlockState():
             inbound(XXX),
-            anyHit(false)
+            anyHit(false),
+            imageStor(0),
+            cntAttempts(0),
+            cntJoined(0),
+            cntThreeWay(0),
+            cntSkipped(0),
+            cntSkippedThreeWay(0),
+            failStreak(0),
+            failStreakThreeWay(0),
+            joinTime(0.0)
         {
         }
     };
 
     std::map<TBlock, BlockState>        cont;
+
+    /// blocks that are going to be cooled down, the least recently used first
+    std::vector<TBlock>                 warm;
+
+    BlockState& lookup(TBlock bb);
+    void pack(TBlock bb);
+
+    bool insertAdaptive(
+            BlockState                 &ref,
+            TBlock                      bb,
+            SymHeap                    &sh,
+            bool                        allowThreeWay);
 };
 
+/// count of completed blocks whose states are kept expanded in SymStateMap
+static const unsigned cntWarmBlocks = 0x10;
+
+// expand the state of the given block if it is cold
+SymStateMap::Private::BlockState& SymStateMap::Private::lookup(TBlock bb) {
+    BlockState &ref = this->cont[bb];
+    if (ref.imageTraces.empty()) {
+        // the block is in use again, do not cool it down
+        std::vector<TBlock>::iterator it =
+            std::find(this->warm.begin(), this->warm.end(), bb);
+        if (this->warm.end() != it)
+            this->warm.erase(it);
+
+        return ref;
+    }
+
+    SymStateMarked &state = ref.state;
+    CL_BREAK_IF(state.size());
+
+    PackReader src(ref.image);
+    BOOST_FOREACH(const Trace::NodeHandle &trace, ref.imageTraces) {
+        SymHeap sh(*ref.imageStor, trace.node());
+        sh.unpack(src);
+
+        // the heaps of a cold state have all been processed already
+        state.insertNew(std::move(sh));
+        state.setDone(state.size() - 1);
+    }
+
+    CL_BREAK_IF(!src.atEnd());
+    CL_DEBUG("SymStateMap::lookup() expanded a cold state of " << bb->name()
+            << " (" << state.size() << " heaps, " << ref.image.size()
+            << " bytes)");
+
+    std::string().swap(ref.image);
+    TTraceList().swap(ref.imageTraces);
+    return ref;
+}
+
+void SymStateMap::Private::pack(TBlock bb) {
+    BlockState &ref = this->cont[bb];
+    SymStateMarked &state = ref.state;
+    CL_BREAK_IF(state.cntPending() || !ref.imageTraces.empty());
+    ref.imageStor = &state[0].stor();
+
+    PackWriter dst(ref.image);
+    BOOST_FOREACH(const SymHeap *sh, state) {
+        ref.imageTraces.push_back(Trace::NodeHandle(sh->traceNode()));
+        sh->pack(dst);
+    }
+
+    // release the spare capacity of the buffer
+    std::string(ref.image).swap(ref.image);
+
+    CL_DEBUG("SymStateMap::pack() packed the state of " << bb->name()
+            << " (" << state.size() << " heaps) into "
+            << ref.image.size() << " bytes");
+
+    state.clear();
+}
+
+/// true if the operation switched off at a block is to be attempted again now
+static bool retryNow(unsigned *pCntSkipped) {
+    return !(++(*pCntSkipped) % (SE_ADAPTIVE_JOIN_RETRY));
+}
+
+// insert the heap, attempt join only where it has a chance to succeed
+bool SymStateMap::Private::insertAdaptive(
+        BlockState                     &ref,
+        TBlock                          bb,
+        SymHeap                        &sh,
+        bool                            allowThreeWay)
+{
+    SymStateMarked &state = ref.state;
+    const int size = state.size();
+    if (!size)
+        // nothing to join with
+        return state.insert(std::move(sh), allowThreeWay);
+
+    const unsigned thr = (SE_ADAPTIVE_JOIN_FAIL_STREAK);
+    const struct cl_loc *loc = &bb->front()->loc;
+    const std::string &name = bb->name();
+
+    if (1 < sePolicy().adaptiveJoin && thr <= ref.failStreak) {
+        if (!retryNow(&ref.cntSkipped))
+            // join switched off at this block, check for isomorphism only
+            return state.SymHeapUnion::insert(std::move(sh), allowThreeWay);
+
+        CL_DEBUG_MSG(loc, "<A> retrying join at block " << name
+                << " after " << ref.cntSkipped << " insertions without join");
+    }
+
+    bool threeWay = allowThreeWay;
+    if (threeWay && thr <= ref.failStreakThreeWay) {
+        if (retryNow(&ref.cntSkippedThreeWay))
+            CL_DEBUG_MSG(loc, "<A> retrying three-way join at block " << name
+                    << " after " << ref.cntSkippedThreeWay
+                    << " insertions without three-way join");
+        else
+            threeWay = false;
+    }
+
+    // attempt join and measure the cost
+    const clock_t start = clock();
+    bool didThreeWay;
+    const bool changed = state.insertByJoin(std::move(sh), threeWay,
+            &didThreeWay);
+    ref.joinTime += static_cast<float>(clock() - start) / CLOCKS_PER_SEC;
+    ++ref.cntAttempts;
+
+    const bool grew = (size < static_cast<int>(state.size()));
+    if (!grew) {
+        ++ref.cntJoined;
+        if (thr <= ref.failStreak && 1 < sePolicy().adaptiveJoin)
+            CL_DEBUG_MSG(loc, "<A> switching join back on at block " << name);
+
+        ref.failStreak = 0;
+    }
+    else if (thr == ++ref.failStreak && 1 < sePolicy().adaptiveJoin) {
+        CL_DEBUG_MSG(loc, "<A> switching off join at block " << name
+                << ", " << thr << " attempts failed in a row, "
+                << ref.cntJoined << " of " << ref.cntAttempts
+                << " attempts succeeded, " << ref.joinTime << " s spent");
+        ref.cntSkipped = 0;
+    }
+
+    if (!threeWay)
+        return changed;
+
+    if (didThreeWay) {
+        ++ref.cntThreeWay;
+        if (thr <= ref.failStreakThreeWay)
+            CL_DEBUG_MSG(loc, "<A> switching three-way join back on at block "
+                    << name);
+
+        ref.failStreakThreeWay = 0;
+    }
+    else if (!grew)
+        // the heap was joined without three-way join, which is no failure
+        return changed;
+    else if (thr == ++ref.failStreakThreeWay) {
+        CL_DEBUG_MSG(loc, "<A> switching off three-way join at block " << name
+                << ", " << thr << " attempts failed in a row, "
+                << ref.cntThreeWay << " of " << ref.cntAttempts
+                << " attempts ended up in three-way join, "
+                << ref.joinTime << " s spent");
+        ref.cntSkippedThreeWay = 0;
+    }
+
+    return changed;
+}
+
 // TODO: drop this!
 SymStateMap SymStateMap::Private::BlockState::XXX;
 
@@ -515,7 +787,7 @@ SymStateMap::~SymStateMap() {
 }
 
 SymStateMarked& SymStateMap::operator[](const CodeStorage::Block *bb) {
-    return d->cont[bb].state;
+    return d->lookup(bb).state;
 }
 
 bool SymStateMap::insert(
@@ -523,23 +795,36 @@ bool SymStateMap::insert(
         const CodeStorage::Block        *src,
         const SymHeap                   &sh,
         const bool                      allowThreeWay)
+{
+    SymHeap dup(sh);
+    Trace::waiveCloneOperation(dup);
+    return this->insert(dst, src, std::move(dup), allowThreeWay);
+}
+
+bool SymStateMap::insert(
+        const CodeStorage::Block        *dst,
+        const CodeStorage::Block        *src,
+        SymHeap                         &&sh,
+        const bool                      allowThreeWay)
 {
     // look for the _target_ block
-    Private::BlockState &ref = d->cont[dst];
+    Private::BlockState &ref = d->lookup(dst);
     const unsigned size = ref.state.size();
 
     // insert the given symbolic heap
     bool changed = true;
-#if 2 < SE_JOIN_ON_LOOP_EDGES_ONLY
-    if (1 == dst->inbound().size() && (cl_is_term_insn(dst->front()->code)
+    if (2 < sePolicy().joinOnLoopEdgesOnly && 1 == dst->inbound().size()
+            && (cl_is_term_insn(dst->front()->code)
                 || (CL_INSN_COND == dst->back()->code && 2 == dst->size())))
     {
         CL_DEBUG("SymStateMap::insert() bypasses even the isomorphism check");
-        ref.state.insertNew(sh);
+        ref.state.insertNew(std::move(sh));
     }
+    else if (!sePolicy().adaptiveJoin
+            || (!allowThreeWay && 1 < sePolicy().joinOnLoopEdgesOnly))
+        changed = ref.state.insert(std::move(sh), allowThreeWay);
     else
-#endif
-        changed = ref.state.insert(sh, allowThreeWay);
+        changed = d->insertAdaptive(ref, dst, sh, allowThreeWay);
 
     if (ref.state.size() <= size)
         // if the size did not grow, there must have been at least join
@@ -557,9 +842,31 @@ bool SymStateMap::anyReuseHappened(const CodeStorage::Block *bb) const {
 }
 
 int SymStateMap::cntPending(const CodeStorage::Block *bb) const {
+    // a cold state has no pending heaps, no need to expand it
     return d->cont[bb].state.cntPending();
 }
 
+void SymStateMap::coolDown(const CodeStorage::Block *bb) {
+#if SE_COLD_STATE_MIN_HEAPS
+    // this removes the block from the list of warm blocks if it is there
+    const SymStateMarked &state = d->lookup(bb).state;
+    if (state.cntPending() || state.size() < (SE_COLD_STATE_MIN_HEAPS))
+        return;
+
+    // loops often come back to recently completed blocks, delay the packing
+    std::vector<Private::TBlock> &warm = d->warm;
+    warm.push_back(bb);
+    if (warm.size() <= cntWarmBlocks)
+        return;
+
+    const Private::TBlock lru = warm.front();
+    warm.erase(warm.begin());
+    d->pack(lru);
+#else
+    (void) bb;
+#endif
+}
+
 void SymStateMap::gatherInboundEdges(TContBlock                  &dst,
                                      const CodeStorage::Block    *ofBlock)
     const
@@ -26,6 +26,7 @@
  */
 
 #include <set>
+#include <utility>
 #include <vector>
 
 #include "symheap.hh"
@@ -64,6 +65,9 @@ class SymState {
         /// insert given SymHeap object into the state
         virtual bool insert(const SymHeap &sh, bool allowThreeWay = true);
 
+        /// the same as above, but the given heap is moved into the state
+        virtual bool insert(SymHeap &&sh, bool allowThreeWay = true);
+
         /// return count of object stored in the container
         size_t size()          const { return heaps_.size();  }
 
@@ -88,6 +92,9 @@ class SymState {
         /// insert @b new SymHeap that @ must be guaranteed to be not yet in
         virtual void insertNew(const SymHeap &sh);
 
+        /// the same as above, but the given heap is moved into the state
+        virtual void insertNew(SymHeap &&sh);
+
         virtual void eraseExisting(int nth) {
             delete heaps_[nth];
             heaps_.erase(heaps_.begin() + nth);
@@ -124,6 +131,13 @@ class SymHeapList: public SymState {
             return *this;
         }
 
+        using SymState::operator[];
+
+        /// write access to the nth heap, e.g. to move it out of the list
+        SymHeap& operator[](int nth) {
+            return **(this->begin() + nth);
+        }
+
         virtual int lookup(const SymHeap &) const {
             return /* not found */ -1;
         }
@@ -146,8 +160,22 @@ class SymHeapUnion: public SymState {
 class SymStateWithJoin: public SymHeapUnion {
     public:
         virtual bool insert(const SymHeap &sh, bool allowThreeWay = true);
+        virtual bool insert(SymHeap &&sh, bool allowThreeWay = true);
+
+        /**
+         * the same as above, but it never falls back to the isomorphism check
+         * because of SE_JOIN_ON_LOOP_EDGES_ONLY
+         * @param pThreeWay set to true if three-way join has taken place
+         */
+        bool insertByJoin(SymHeap &&sh, bool allowThreeWay, bool *pThreeWay);
 
     private:
+        bool insertWork(
+                const SymHeap                       &shNew,
+                SymHeap                             *pOwned,
+                bool                                allowThreeWay,
+                bool                                *pThreeWay = 0);
+
         void packState(unsigned idx, bool allowThreeWay);
 };
 
@@ -190,10 +218,12 @@ class SymStateMarked: public SymStateWithJoin {
     protected:
         virtual void insertNew(const SymHeap &sh) {
             SymStateWithJoin::insertNew(sh);
+            this->scheduleLast();
+        }
 
-            // schedule the just inserted SymHeap for processing
-            done_.push_back(false);
-            ++cntPending_;
+        virtual void insertNew(SymHeap &&sh) {
+            SymStateWithJoin::insertNew(std::move(sh));
+            this->scheduleLast();
         }
 
         virtual void eraseExisting(int nth) {
@@ -237,6 +267,12 @@ class SymStateMarked: public SymStateWithJoin {
 
         TDone           done_;
         int             cntPending_;
+
+        /// schedule the just inserted SymHeap for processing
+        void scheduleLast() {
+            done_.push_back(false);
+            ++cntPending_;
+        }
 };
 
 class IPendingCountProvider {
@@ -276,6 +312,13 @@ class SymStateMap: public IPendingCountProvider {
                     const bool                              allowThreeWay = true
                     );
 
+        /// the same as above, but the given heap is moved into the state
+        bool insert(const CodeStorage::Block                *dst,
+                    const CodeStorage::Block                *src,
+                    SymHeap                                 &&sh,
+                    const bool                              allowThreeWay = true
+                    );
+
         /**
          * returns all blocks that inserted something to the given state
          * @param dst a container where the result should be stored to
@@ -293,6 +336,14 @@ class SymStateMap: public IPendingCountProvider {
 
         virtual int cntPending(const CodeStorage::Block *) const;
 
+        /**
+         * notify the container that the given block has been completed.  If
+         * the block is not accessed until a few other blocks are completed, its
+         * state is moved to a compact image (see SE_COLD_STATE_MIN_HEAPS),
+         * which is transparently expanded on the next access of the state.
+         */
+        void coolDown(const CodeStorage::Block *);
+
     private:
         /// object copying is @b not allowed
         SymStateMap(const SymStateMap &);
@@ -69,6 +69,10 @@ void Node::notifyDeath(NodeBase *child) {
         delete this;
 }
 
+void Node::notifyRelocation(NodeBase *from, NodeBase *to) {
+    std::replace(children_.begin(), children_.end(), from, to);
+}
+
 
 // /////////////////////////////////////////////////////////////////////////////
 // implementation of Trace::NodeHandle
@@ -83,6 +87,27 @@ void NodeHandle::reset(Node *node) {
     ref->notifyBirth(this);
 }
 
+NodeHandle::NodeHandle(NodeHandle &&tpl) throw() {
+    parents_.swap(tpl.parents_);
+    BOOST_FOREACH(Node *node, parents_)
+        node->notifyRelocation(&tpl, this);
+}
+
+NodeHandle& NodeHandle::operator=(NodeHandle &&tpl) throw() {
+    if (parents_ == tpl.parents_)
+        // both handles refer to the same node (or none), nothing to exchange
+        return *this;
+
+    BOOST_FOREACH(Node *node, parents_)
+        node->notifyRelocation(this, &tpl);
+
+    BOOST_FOREACH(Node *node, tpl.parents_)
+        node->notifyRelocation(&tpl, this);
+
+    parents_.swap(tpl.parents_);
+    return *this;
+}
+
 
 // /////////////////////////////////////////////////////////////////////////////
 // implementation of Trace::plotTrace()
@@ -88,6 +88,9 @@ class Node: public NodeBase {
         /// death notification from a child node
         void notifyDeath(NodeBase *child);
 
+        /// a child node has been moved to another address
+        void notifyRelocation(NodeBase *from, NodeBase *to);
+
         friend class NodeBase;
         friend class NodeHandle;
 
@@ -162,6 +165,12 @@ class NodeHandle: public NodeBase {
             this->reset(tpl.node());
             return *this;
         }
+
+        /// take over the node of the given handle, which is left empty
+        NodeHandle(NodeHandle &&tpl) throw();
+
+        /// exchange the nodes of both handles, no reference count is touched
+        NodeHandle& operator=(NodeHandle &&tpl) throw();
 };
 
 /// used to explicitly highlight trace graph nodes that should not be reachable
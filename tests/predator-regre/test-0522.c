@@ -0,0 +1,55 @@
+#include <stdlib.h>
+
+struct node {
+    struct node *next;
+};
+
+static struct node* push(struct node *list)
+{
+    struct node *node = malloc(sizeof *node);
+    if (!node)
+        abort();
+
+    node->next = list;
+    return node;
+}
+
+static struct node* pop(struct node *list)
+{
+    struct node *next = list->next;
+    free(list);
+    return next;
+}
+
+int main()
+{
+    struct node *list = NULL;
+
+    // each call of push() sees a longer list, thus a new call context
+    list = push(list);
+    list = push(list);
+    list = push(list);
+    list = push(list);
+    list = push(list);
+
+    // the same holds for pop() until the list gets abstracted
+    while (list)
+        list = pop(list);
+
+    return 0;
+}
+
+/**
+ * @file test-0522.c
+ *
+ * @brief regression test focused on bounded call cache
+ *
+ * - each function is called in several distinct call contexts
+ * - run also with a tightly bounded call cache, where the
+ *   contexts are evicted as soon as their results are stored
+ * - the verdict has to be the same as with the unbounded call cache
+ *
+ * @attention
+ * This description is automatically imported from tests/predator-regre/README.
+ * Any changes made to this comment will be thrown away on the next import.
+ */
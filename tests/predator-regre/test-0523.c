@@ -0,0 +1,70 @@
+#include <verifier-builtins.h>
+#include <stdlib.h>
+
+struct node {
+    struct node *next;
+    int data;
+};
+
+static struct node* push(struct node *list, int data)
+{
+    struct node *node = malloc(sizeof *node);
+    if (!node)
+        abort();
+
+    node->next = list;
+    node->data = data;
+    return node;
+}
+
+static int length(const struct node *list)
+{
+    int len = 0;
+    for (; list; list = list->next)
+        ++len;
+
+    return len;
+}
+
+int main()
+{
+    struct node *list = push(push(NULL, 1), 2);
+    int i;
+
+    // the first call of length() in this call context
+    length(list);
+
+    // allocate and release a bunch of objects, the IDs of most objects in the
+    // heap are no longer in use then, so the heap gets renumbered once it is
+    // inserted into the state of a basic block
+    for (i = 0; i < 0x20; ++i) {
+        struct node *tmp = malloc(sizeof *tmp);
+        free(tmp);
+    }
+
+    // the same call context as above, the renumbered heap has to match it
+    length(list);
+
+    while (list) {
+        struct node *next = list->next;
+        free(list);
+        list = next;
+    }
+
+    return 0;
+}
+
+/**
+ * @file test-0523.c
+ *
+ * @brief regression test focused on compaction of entity IDs
+ *
+ * - most of the objects allocated in the heap are released,
+ *   so the heap gets renumbered densely once it is stored
+ *   into the state of a basic block
+ * - the renumbered heap still has to hit the call cache
+ *
+ * @attention
+ * This description is automatically imported from tests/predator-regre/README.
+ * Any changes made to this comment will be thrown away on the next import.
+ */
@@ -0,0 +1,97 @@
+#include <verifier-builtins.h>
+#include <stdlib.h>
+
+extern int __VERIFIER_nondet_int(void);
+
+static void error(void)
+{
+ERROR:
+    goto ERROR;
+}
+
+struct node {
+    struct node *next;
+    int data;
+};
+
+static struct node* alloc_node(void)
+{
+    struct node *node = malloc(sizeof *node);
+    if (!node)
+        abort();
+
+    node->next = NULL;
+    node->data = 0;
+    return node;
+}
+
+int main()
+{
+    struct node *a = alloc_node();
+    struct node *b = alloc_node();
+    struct node *p0, *p1, *p2, *p3, *p4;
+
+    do {
+        // 2^5 distinct heaps, none of them can be joined with another one
+        p0 = (__VERIFIER_nondet_int()) ? a : b;
+        p1 = (__VERIFIER_nondet_int()) ? a : b;
+        p2 = (__VERIFIER_nondet_int()) ? a : b;
+        p3 = (__VERIFIER_nondet_int()) ? a : b;
+        p4 = (__VERIFIER_nondet_int()) ? a : b;
+
+        // each of the blocks below gets all the heaps, so the states of the
+        // blocks completed first are packed while the later ones are executed
+        if (p0 != a && p0 != b)
+            error();
+        if (p1 != a && p1 != b)
+            error();
+        if (p2 != a && p2 != b)
+            error();
+        if (p3 != a && p3 != b)
+            error();
+        if (p4 != a && p4 != b)
+            error();
+
+        p0->data = 1;
+        p1->data = 1;
+        p2->data = 1;
+        p3->data = 1;
+        p4->data = 1;
+
+        if (p0->data != 1 || p1->data != 1)
+            error();
+        if (p2->data != 1 || p3->data != 1)
+            error();
+        if (p4->data != 1)
+            error();
+
+        if (p0 == p1 && p0->next)
+            error();
+        if (p2 == p3 && p2->next)
+            error();
+        if (p3 == p4 && p4->next)
+            error();
+
+        // the heaps come back to the packed states, which need to be expanded
+        // to find out that there is nothing new in them
+    } while (__VERIFIER_nondet_int());
+
+    free(a);
+    free(b);
+    return 0;
+}
+
+/**
+ * @file test-0524.c
+ *
+ * @brief regression test focused on packing of cold states
+ *
+ * - the states of the blocks in the loop body hold 32 heaps
+ *   each, those completed first are packed while the rest of
+ *   the loop body is executed
+ * - the next iteration has to expand the packed states again
+ *
+ * @attention
+ * This description is automatically imported from tests/predator-regre/README.
+ * Any changes made to this comment will be thrown away on the next import.
+ */
@@ -0,0 +1,75 @@
+#include <verifier-builtins.h>
+#include <stdlib.h>
+
+extern int __VERIFIER_nondet_int(void);
+
+static void error(void)
+{
+ERROR:
+    goto ERROR;
+}
+
+struct node {
+    struct node *next;
+    int data;
+};
+
+int main()
+{
+    struct node *a = malloc(sizeof *a);
+    struct node *b = malloc(sizeof *b);
+    struct node *c = malloc(sizeof *c);
+    struct node *x, *y;
+
+    if (!a || !b || !c)
+        abort();
+
+    // four heaps enter the straight-line code below
+    x = (__VERIFIER_nondet_int()) ? a : b;
+    y = (__VERIFIER_nondet_int()) ? b : c;
+
+    // no calls and no conditional jumps here, so each heap is run through
+    // the whole sequence of instructions before the next heap is taken
+    a->next = b;
+    b->next = c;
+    c->next = NULL;
+    a->data = 0;
+    b->data = 0;
+    c->data = 0;
+    x->data = 1;
+    y->data = 2;
+    x->next->data = 3;
+    y->next = x;
+
+    // the writes above have to be seen in the order given by the program
+    if (x->data != 1 && x->data != 2)
+        error();
+    if (y->data != 2 && y->data != 3)
+        error();
+    if (y->next != x)
+        error();
+    if (a->next != b)
+        error();
+    if (c->next && c->next != x)
+        error();
+
+    free(a);
+    free(b);
+    free(c);
+    return 0;
+}
+
+/**
+ * @file test-0525.c
+ *
+ * @brief regression test focused on fused execution of block segments
+ *
+ * - four heaps run through a straight-line sequence of stores
+ *   through aliased pointers, executed instruction by instruction
+ * - run also with each heap run through the whole segment before
+ *   the next one, the verdict has to be the same
+ *
+ * @attention
+ * This description is automatically imported from tests/predator-regre/README.
+ * Any changes made to this comment will be thrown away on the next import.
+ */
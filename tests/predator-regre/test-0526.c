@@ -0,0 +1,84 @@
+#include <verifier-builtins.h>
+#include <stdlib.h>
+
+extern int __VERIFIER_nondet_int(void);
+
+static void error(void)
+{
+ERROR:
+    goto ERROR;
+}
+
+struct node {
+    struct node *next;
+    int data;
+};
+
+static struct node* alloc_node(struct node *next)
+{
+    struct node *node = malloc(sizeof *node);
+    if (!node)
+        abort();
+
+    node->next = next;
+    node->data = 0;
+    return node;
+}
+
+int main()
+{
+    struct node *a = alloc_node(NULL);
+    struct node *b = alloc_node(NULL);
+    struct node *list = NULL;
+    struct node *p0, *p1, *p2, *p3, *p4;
+
+    // 2^5 heaps that differ in aliasing, none of them can be joined
+    p0 = (__VERIFIER_nondet_int()) ? a : b;
+    p1 = (__VERIFIER_nondet_int()) ? a : b;
+    p2 = (__VERIFIER_nondet_int()) ? a : b;
+    p3 = (__VERIFIER_nondet_int()) ? a : b;
+    p4 = (__VERIFIER_nondet_int()) ? a : b;
+
+    // join at the loop head keeps failing for heaps that differ in aliasing
+    // of the pointers above, but it still has to succeed for heaps that differ
+    // only in length of the list, otherwise the loop never terminates
+    while (__VERIFIER_nondet_int())
+        list = alloc_node(list);
+
+    if (p0 != a && p0 != b)
+        error();
+    if (p1 != a && p1 != b)
+        error();
+    if (p2 != a && p2 != b)
+        error();
+    if (p3 != a && p3 != b)
+        error();
+    if (p4 != a && p4 != b)
+        error();
+
+    while (list) {
+        struct node *next = list->next;
+        free(list);
+        list = next;
+    }
+
+    free(a);
+    free(b);
+    return 0;
+}
+
+/**
+ * @file test-0526.c
+ *
+ * @brief regression test focused on adaptive join
+ *
+ * - join at the loop head keeps failing for heaps that differ
+ *   in aliasing
+ * - run also with adaptive join, which switches the join off
+ *   there for a while, and with the fall-back to isomorphism
+ *   check, the verdict has to be the same
+ *
+ * @attention
+ * This description is automatically imported from tests/predator-regre/README.
+ * Any changes made to this comment will be thrown away on the next import.
+ */
@@ -0,0 +1,80 @@
+#include <verifier-builtins.h>
+#include <stdlib.h>
+
+extern int __VERIFIER_nondet_int(void);
+
+struct node {
+    struct node *next;
+    int data;
+};
+
+static struct node* alloc_node(struct node *next, int data)
+{
+    struct node *node = malloc(sizeof *node);
+    if (!node)
+        abort();
+
+    node->next = next;
+    node->data = data;
+    return node;
+}
+
+int main()
+{
+    struct node *list = NULL;
+    struct node *item = NULL;
+    int stats = 0;
+    int keep = 0;
+    int tmp = 0;
+    int data = 0;
+
+    // the stores to 'stats' cannot influence the heap, they are sliced away
+    while (__VERIFIER_nondet_int()) {
+        list = alloc_node(list, 0);
+        ++stats;
+    }
+
+    stats = stats * 2 + 1;
+
+    if (__VERIFIER_nondet_int()) {
+        // 'tmp' flows into a condition through 'keep', it has to be kept
+        item = alloc_node(NULL, 0);
+        tmp = 1;
+        keep = tmp;
+
+        // 'data' flows into the heap, it has to be kept, too
+        data = 7;
+        item->data = data;
+    }
+
+    if (keep) {
+        if (item->data != 7)
+            // not reachable unless the store to 'data' is sliced away
+            item->next = item;
+        else
+            free(item);
+    }
+
+    while (list) {
+        struct node *next = list->next;
+        free(list);
+        list = next;
+    }
+
+    return 0;
+}
+
+/**
+ * @file test-0527.c
+ *
+ * @brief regression test focused on slicing of irrelevant instructions
+ *
+ * - the stores to a counter that never flows into the heap are
+ *   sliced away (with CL_EASY_SLICE_INSNS enabled)
+ * - the stores that flow into a condition or into the heap only
+ *   transitively have to be kept, otherwise a leak is reported
+ *
+ * @attention
+ * This description is automatically imported from tests/predator-regre/README.
+ * Any changes made to this comment will be thrown away on the next import.
+ */
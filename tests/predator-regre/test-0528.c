@@ -0,0 +1,71 @@
+#include <verifier-builtins.h>
+#include <stdlib.h>
+
+extern int __VERIFIER_nondet_int(void);
+
+struct node {
+    struct node *next;
+    int data;
+};
+
+static struct node* alloc_node(struct node *next)
+{
+    struct node *node = malloc(sizeof *node);
+    if (!node)
+        abort();
+
+    node->next = next;
+    node->data = 0;
+    return node;
+}
+
+int main()
+{
+    struct node *list = alloc_node(NULL);
+    int verbose = 0;
+    int owned = 0;
+    int *pOwned = &owned;
+    int done = 0;
+
+    if (verbose) {
+        // the condition is folded and this block is removed as dead code
+        list = NULL;
+    }
+
+    // 'owned' is written through a pointer, the condition below is not known
+    *pOwned = 1;
+
+    // 'done' changes in the loop body, the loop condition is not known either
+    while (!done) {
+        list = alloc_node(list);
+        if (__VERIFIER_nondet_int())
+            done = 1;
+    }
+
+    if (owned) {
+        while (list) {
+            struct node *next = list->next;
+            free(list);
+            list = next;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @file test-0528.c
+ *
+ * @brief regression test focused on folding of constant conditions
+ *
+ * - a condition with known outcome is folded and the block
+ *   guarded by it is removed as dead code (with
+ *   CL_EASY_FOLD_CONST_CONDS enabled)
+ * - conditions on a variable written through a pointer and on
+ *   a variable changed in a loop have to be kept, otherwise the
+ *   verdict changes
+ *
+ * @attention
+ * This description is automatically imported from tests/predator-regre/README.
+ * Any changes made to this comment will be thrown away on the next import.
+ */
@@ -0,0 +1,45 @@
+#include <stdlib.h>
+
+// the second translation unit of test-0529.c
+
+struct node {
+    struct node *next;
+};
+
+struct list_ops {
+    struct node*    (*push)(struct node *);
+    void            (*destroy)(struct node *);
+};
+
+static struct node* push(struct node *list)
+{
+    struct node *node = malloc(sizeof *node);
+    if (!node)
+        abort();
+
+    node->next = list;
+    return node;
+}
+
+static void destroy(struct node *list)
+{
+    while (list) {
+        struct node *next = list->next;
+        free(list);
+        list = next;
+    }
+}
+
+struct list_ops list_ops = {
+    .push       = push,
+    .destroy    = destroy
+};
+
+struct node* list_create(int len)
+{
+    struct node *list = NULL;
+    while (len--)
+        list = list_ops.push(list);
+
+    return list;
+}
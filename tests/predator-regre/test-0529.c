@@ -0,0 +1,39 @@
+#include <stdlib.h>
+
+struct node {
+    struct node *next;
+};
+
+struct list_ops {
+    struct node*    (*push)(struct node *);
+    void            (*destroy)(struct node *);
+};
+
+// defined in test-0529-ops.c, which is compiled into a separate code model
+extern struct list_ops list_ops;
+extern struct node* list_create(int len);
+
+int main()
+{
+    struct node *list = list_create(2);
+    list = list_ops.push(list);
+    list_ops.destroy(list);
+    return 0;
+}
+
+/**
+ * @file test-0529.c
+ *
+ * @brief regression test focused on linking of code models
+ *
+ * - compiled together with test-0529-ops.c into two code models,
+ *   which are then linked together by predator-run
+ * - the global variable holding pointers to functions is defined
+ *   by the code model that is replayed as the second one
+ * - the initializer of the variable has to refer to the linked
+ *   functions, otherwise the indirect calls cannot be resolved
+ *
+ * @attention
+ * This description is automatically imported from tests/predator-regre/README.
+ * Any changes made to this comment will be thrown away on the next import.
+ */